@@ -0,0 +1,203 @@
+/* Pinning of the benchmark threads to CPUs */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <assert.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "affinity.h"
+
+int pinpolicy = PIN_NONE;
+const char *pinnames[] = {"none", "list", "compact", "scatter", NULL};
+
+static int cpus[MAXCPUS]; // thread t on cpus[t%ncpus]
+static int ncpus = 0;
+
+int pinlist(const char *list)
+{
+  const char *s;
+  char *end;
+  long lo, hi;
+
+  ncpus = 0;
+  s = list;
+  while (*s != '\0') {
+    lo = strtol(s, &end, 10);
+    if (end == s || lo < 0)
+      return 0;
+    hi = lo;
+    if (*end == '-') {
+      s = end+1;
+      hi = strtol(s, &end, 10);
+      if (end == s || hi < lo)
+        return 0;
+    }
+    for (; lo <= hi && ncpus < MAXCPUS; lo++)
+      cpus[ncpus++] = (int)lo;
+    s = end;
+    if (*s == ',')
+      s++;
+    else if (*s != '\0')
+      return 0;
+  }
+  pinpolicy = PIN_LIST;
+  return ncpus > 0;
+}
+
+typedef struct {
+  int cpu, package, core;
+  int smt;  // hyperthread of its core, from 0
+  int rank; // among the CPUs of its package, cores before hyperthreads
+} place_t;
+
+static int readid(int cpu, const char *what, int otherwise)
+{
+  char path[128];
+  FILE *f;
+  int id;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, what);
+  f = fopen(path, "r");
+  if (f == NULL)
+    return otherwise;
+  if (fscanf(f, "%d", &id) != 1)
+    id = otherwise;
+  fclose(f);
+  return id;
+}
+
+static int bycore(const void *a, const void *b)
+{
+  const place_t *x = (const place_t*)a, *y = (const place_t*)b;
+
+  if (x->package != y->package) return x->package-y->package;
+  if (x->core != y->core) return x->core-y->core;
+  return x->cpu-y->cpu;
+}
+
+static int byrank(const void *a, const void *b)
+{
+  const place_t *x = (const place_t*)a, *y = (const place_t*)b;
+
+  if (x->rank != y->rank) return x->rank-y->rank;
+  return x->package-y->package;
+}
+
+static int bysmt(const void *a, const void *b)
+{
+  const place_t *x = (const place_t*)a, *y = (const place_t*)b;
+
+  if (x->package != y->package) return x->package-y->package;
+  if (x->smt != y->smt) return x->smt-y->smt;
+  return x->core-y->core;
+}
+
+// the allowed CPUs by package and core
+static int topology(place_t *places, int *sockets)
+{
+  int i, n;
+
+  n = 0;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  for (i = 0; i < CPU_SETSIZE && i < MAXCPUS; i++) {
+    if (!CPU_ISSET(i, &allowed))
+      continue;
+    places[n].cpu = i;
+    places[n].package = readid(i, "physical_package_id", 0);
+    places[n].core = readid(i, "core_id", i);
+    n++;
+  }
+#endif
+
+  qsort(places, n, sizeof(place_t), bycore);
+  *sockets = 0;
+  for (i = 0; i < n; i++) {
+    if (i == 0 || places[i].package != places[i-1].package)
+      (*sockets)++;
+    places[i].smt = (i > 0 && places[i].package == places[i-1].package &&
+                     places[i].core == places[i-1].core) ? places[i-1].smt+1 : 0;
+  }
+  return n;
+}
+
+int pinorder(int policy)
+{
+  place_t *places;
+  int i, n, sockets;
+
+  places = (place_t*)malloc(MAXCPUS*sizeof(place_t));
+  assert(places != NULL);
+  n = topology(places, &sockets); // compact
+  if (policy == PIN_SCATTER) {
+    qsort(places, n, sizeof(place_t), bysmt);
+    for (i = 0; i < n; i++)
+      places[i].rank = (i > 0 && places[i].package == places[i-1].package) ? places[i-1].rank+1 : 0;
+    qsort(places, n, sizeof(place_t), byrank);
+  }
+
+  ncpus = n;
+  for (i = 0; i < n; i++)
+    cpus[i] = places[i].cpu;
+  free(places);
+  pinpolicy = (n > 0) ? policy : PIN_NONE;
+
+  return sockets;
+}
+
+int pinsockets(void)
+{
+  place_t *places;
+  int sockets;
+
+  places = (place_t*)malloc(MAXCPUS*sizeof(place_t));
+  assert(places != NULL);
+  topology(places, &sockets);
+  free(places);
+
+  return sockets;
+}
+
+void pin(int t)
+{
+#ifdef __linux__
+  cpu_set_t set;
+
+  if (pinpolicy == PIN_NONE || ncpus == 0)
+    return;
+  CPU_ZERO(&set);
+  CPU_SET(cpus[t%ncpus], &set);
+  sched_setaffinity(0, sizeof(set), &set); // the calling thread
+#endif
+}
+
+// runs of consecutive CPUs as lo-hi, joined by +, for CSV
+char *pinstring(char *buf, size_t size)
+{
+  size_t len;
+  int i, j;
+
+  buf[0] = '\0';
+  if (pinpolicy == PIN_NONE) {
+    snprintf(buf, size, "any");
+    return buf;
+  }
+  len = 0;
+  for (i = 0; i < ncpus && len < size; i = j) {
+    for (j = i+1; j < ncpus && cpus[j] == cpus[j-1]+1; j++);
+    if (j-1 > i)
+      len += snprintf(buf+len, size-len, "%s%d-%d", (i > 0) ? "+" : "", cpus[i], cpus[j-1]);
+    else
+      len += snprintf(buf+len, size-len, "%s%d", (i > 0) ? "+" : "", cpus[i]);
+  }
+  return buf;
+}
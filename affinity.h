@@ -0,0 +1,24 @@
+/* Pinning of the benchmark threads to CPUs */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stddef.h>
+
+#define PIN_NONE    0 // wherever OpenMP and the operating system put the threads
+#define PIN_LIST    1 // thread t on the t-th CPU of a list
+#define PIN_COMPACT 2 // the CPUs of a core, then of a socket, before the next socket
+#define PIN_SCATTER 3 // round robin over the sockets, cores before their hyperthreads
+
+#define MAXCPUS 4096
+
+extern int pinpolicy;
+extern const char *pinnames[];
+
+int pinlist(const char *list); // CPUs like 0-3,8,10-11; 0 if malformed
+int pinorder(int policy);      // the allowed CPUs in the order of policy; number of sockets
+int pinsockets(void);          // sockets of the allowed CPUs
+void pin(int t);               // the calling thread t on its CPU
+char *pinstring(char *buf, size_t size); // the CPUs in order, like 0-3+8
+
+#endif
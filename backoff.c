@@ -0,0 +1,76 @@
+/* Contention management: per thread backoff after a failed CAS */
+
+#include <stddef.h>
+
+#include "backoff.h"
+
+#ifndef BACKOFF
+#define BACKOFF BACKOFF_NONE
+#endif
+
+int backoffpolicy = BACKOFF;
+unsigned backoffmin = 16;
+unsigned backoffmax = 4096;
+
+const char *backoffnames[] = {"none", "exp", "rand", "adaptive", NULL};
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define PAUSE() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define PAUSE() __asm__ __volatile__("" ::: "memory")
+#endif
+
+// conflicts per operation over a window to double, respectively halve the start
+#define HIGH 0.25
+#define LOW  (1.0/32)
+
+void backoffinit(backoff_t *backoff)
+{
+  // adaptive starts without waiting, and backs off once there are conflicts
+  backoff->start = (backoffpolicy == BACKOFF_ADAPTIVE) ? 0 : backoffmin;
+  backoff->limit = backoff->start;
+  backoff->ops = 0;
+  backoff->conflicts = 0;
+  backoff->seed = 0x9E3779B97F4A7C15UL^(unsigned long)backoff;
+}
+
+void backoffwait(backoff_t *backoff)
+{
+  unsigned i, n;
+
+  n = backoff->limit;
+  if (backoffpolicy == BACKOFF_RAND && n > 0) {
+    // xorshift
+    backoff->seed ^= backoff->seed<<13;
+    backoff->seed ^= backoff->seed>>7;
+    backoff->seed ^= backoff->seed<<17;
+    n = 1+backoff->seed%n;
+  }
+  for (i = 0; i < n; i++)
+    PAUSE();
+
+  if (backoff->limit < backoffmax)
+    backoff->limit = (backoff->limit < backoffmax/2) ? 2*backoff->limit : backoffmax;
+}
+
+void backoffadapt(backoff_t *backoff, unsigned long long conflicts)
+{
+  double rate;
+
+  rate = (conflicts < backoff->conflicts) ? 0.0 : // counters reset
+    (double)(conflicts-backoff->conflicts)/backoff->ops;
+  if (rate > HIGH) {
+    if (backoff->start == 0)
+      backoff->start = backoffmin;
+    else if (backoff->start < backoffmax/2)
+      backoff->start *= 2;
+    else
+      backoff->start = backoffmax;
+  } else if (rate < LOW) {
+    backoff->start = (backoff->start > backoffmin) ? backoff->start/2 : 0;
+  }
+  backoff->ops = 0;
+  backoff->conflicts = conflicts;
+}
@@ -0,0 +1,54 @@
+/* Contention management: per thread backoff after a failed CAS */
+
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// strategies
+#define BACKOFF_NONE     0 // retry immediately
+#define BACKOFF_EXP      1 // wait, doubling the wait up to the maximum
+#define BACKOFF_RAND     2 // wait randomly up to a doubling bound
+#define BACKOFF_ADAPTIVE 3 // as exponential, from a start tuned to the conflicts
+
+#define BACKOFFWINDOW 256 // operations between adaptations
+
+extern int backoffpolicy;               // at build time with -DBACKOFF=BACKOFF_EXP etc.
+extern unsigned backoffmin, backoffmax; // waits in pause instructions
+extern const char *backoffnames[];
+
+typedef struct _backoff {
+  unsigned limit;       // wait after the next failed CAS of this operation
+  unsigned start;       // limit at the start of an operation
+  unsigned ops;         // operations in the current window
+  unsigned long long conflicts; // at the start of the window
+  unsigned long seed;   // BACKOFF_RAND
+} backoff_t;
+
+void backoffinit(backoff_t *backoff);
+void backoffwait(backoff_t *backoff);
+void backoffadapt(backoff_t *backoff, unsigned long long conflicts);
+
+// after a failed CAS
+static inline void backoff(backoff_t *backoff)
+{
+  if (backoffpolicy != BACKOFF_NONE)
+    backoffwait(backoff);
+}
+
+// at the start of an operation; conflicts is a running count of failed
+// CAS and retries of the thread
+static inline void backoffstart(backoff_t *backoff, unsigned long long conflicts)
+{
+  if (backoffpolicy == BACKOFF_ADAPTIVE && ++backoff->ops == BACKOFFWINDOW)
+    backoffadapt(backoff, conflicts);
+  backoff->limit = backoff->start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
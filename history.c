@@ -0,0 +1,402 @@
+/* Recorded histories of set operations and their linearizability check */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <assert.h>
+
+#include "history.h"
+
+const char *histnames[] = {"add", "rem", "con", NULL};
+
+unsigned long long histnow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+void histinit(history_t *hist, long size)
+{
+  hist->event = (event_t*)malloc((size > 0 ? size : 1)*sizeof(event_t));
+  assert(hist->event != NULL);
+  hist->n = 0;
+  hist->size = size;
+  hist->init = NULL;
+  hist->ninit = 0;
+}
+
+void histfree(history_t *hist)
+{
+  free(hist->event);
+  free(hist->init);
+  hist->event = NULL;
+  hist->init = NULL;
+}
+
+void histappend(history_t *hist, const history_t *other)
+{
+  if (hist->n+other->n > hist->size) {
+    hist->size = hist->n+other->n;
+    hist->event = (event_t*)realloc(hist->event, hist->size*sizeof(event_t));
+    assert(hist->event != NULL);
+  }
+  memcpy(hist->event+hist->n, other->event, other->n*sizeof(event_t));
+  hist->n += other->n;
+}
+
+void histstart(history_t *hist, const long keys[], long n)
+{
+  hist->init = (long*)realloc(hist->init, (n > 0 ? n : 1)*sizeof(long));
+  assert(hist->init != NULL);
+  memcpy(hist->init, keys, n*sizeof(long));
+  hist->ninit = n;
+}
+
+int histwrite(const history_t *hist, FILE *file)
+{
+  const event_t *e;
+  long i;
+
+  fprintf(file, "# init <key>, then <thread> <add|rem|con> <key> <result> <invoke ns> <response ns>\n");
+  for (i = 0; i < hist->ninit; i++)
+    fprintf(file, "init %ld\n", hist->init[i]);
+  for (i = 0; i < hist->n; i++) {
+    e = &hist->event[i];
+    fprintf(file, "%d %s %ld %d %llu %llu\n", e->thread, histnames[e->op], e->key, e->res, e->invoke, e->response);
+  }
+  return !ferror(file);
+}
+
+int histread(history_t *hist, FILE *file)
+{
+  char line[256], name[8];
+  event_t e;
+  long key;
+  int op;
+
+  histinit(hist, 1024);
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (line[0] == '#' || line[0] == '\n')
+      continue;
+    if (sscanf(line, "init %ld", &key) == 1) {
+      hist->init = (long*)realloc(hist->init, (hist->ninit+1)*sizeof(long));
+      assert(hist->init != NULL);
+      hist->init[hist->ninit++] = key;
+      continue;
+    }
+    if (sscanf(line, "%d %7s %ld %d %llu %llu", &e.thread, name, &e.key, &e.res, &e.invoke, &e.response) != 6)
+      return 0;
+    for (op = 0; histnames[op] != NULL && strcmp(name, histnames[op]) != 0; op++);
+    if (histnames[op] == NULL || e.response < e.invoke)
+      return 0;
+    e.op = op;
+    if (hist->n == hist->size) {
+      hist->size *= 2;
+      hist->event = (event_t*)realloc(hist->event, hist->size*sizeof(event_t));
+      assert(hist->event != NULL);
+    }
+    hist->event[hist->n++] = e;
+  }
+  return 1;
+}
+
+static int bykey(const void *a, const void *b)
+{
+  const event_t *x = (const event_t*)a, *y = (const event_t*)b;
+
+  if (x->key != y->key) return (x->key > y->key)-(x->key < y->key);
+  return (x->invoke > y->invoke)-(x->invoke < y->invoke);
+}
+
+static int bylong(const void *a, const void *b)
+{
+  long x = *(const long*)a, y = *(const long*)b;
+
+  return (x > y)-(x < y);
+}
+
+// Wing and Gong's search with Lowe's cache of visited configurations
+// (Testing for linearizability, 2017): the calls and returns of the
+// operations on one key in a list ordered by time; the first call in the
+// list is linearized next if the operation gives its result in the
+// current state, a return before any such call backtracks.
+
+typedef struct _entry {
+  struct _entry *prev, *next;
+  struct _entry *match;   // the return of a call
+  unsigned long long time;
+  int ret;                // a return, after the calls of the same time
+  int op;                 // index of the operation
+} entry_t;
+
+typedef struct _config {
+  uint64_t hash;          // 0 for an empty slot
+  long bits;              // offset of its bitset in the arena
+  int state;
+} config_t;
+
+typedef struct _cache {
+  config_t *slot;
+  long slots, used;
+  uint64_t *arena;        // bitsets of words words each
+  long arenasize, arenaused;
+  int words;
+} cache_t;
+
+static int bytime(const void *a, const void *b)
+{
+  const entry_t *x = *(entry_t* const*)a, *y = *(entry_t* const*)b;
+
+  if (x->time != y->time) return (x->time > y->time)-(x->time < y->time);
+  return x->ret-y->ret;
+}
+
+static void cacheinit(cache_t *cache, int words)
+{
+  cache->slots = 1024;
+  cache->used = 0;
+  cache->slot = (config_t*)calloc(cache->slots, sizeof(config_t));
+  cache->words = words;
+  cache->arenasize = 1024*(long)words;
+  cache->arenaused = 0;
+  cache->arena = (uint64_t*)malloc(cache->arenasize*sizeof(uint64_t));
+  assert(cache->slot != NULL && cache->arena != NULL);
+}
+
+static void cachefree(cache_t *cache)
+{
+  free(cache->slot);
+  free(cache->arena);
+}
+
+static void cacheput(cache_t *cache, uint64_t hash, const uint64_t *bits, int state, long offset);
+
+static void cachegrow(cache_t *cache)
+{
+  config_t *old = cache->slot;
+  long i, slots = cache->slots;
+
+  cache->slots *= 2;
+  cache->used = 0;
+  cache->slot = (config_t*)calloc(cache->slots, sizeof(config_t));
+  assert(cache->slot != NULL);
+  for (i = 0; i < slots; i++)
+    if (old[i].hash != 0)
+      cacheput(cache, old[i].hash, NULL, old[i].state, old[i].bits);
+  free(old);
+}
+
+// bits copied into the arena unless at offset already
+static void cacheput(cache_t *cache, uint64_t hash, const uint64_t *bits, int state, long offset)
+{
+  long i;
+
+  if (2*(cache->used+1) > cache->slots)
+    cachegrow(cache);
+  if (bits != NULL) {
+    if (cache->arenaused+cache->words > cache->arenasize) {
+      cache->arenasize *= 2;
+      cache->arena = (uint64_t*)realloc(cache->arena, cache->arenasize*sizeof(uint64_t));
+      assert(cache->arena != NULL);
+    }
+    offset = cache->arenaused;
+    memcpy(cache->arena+offset, bits, cache->words*sizeof(uint64_t));
+    cache->arenaused += cache->words;
+  }
+  for (i = hash&(cache->slots-1); cache->slot[i].hash != 0; i = (i+1)&(cache->slots-1));
+  cache->slot[i].hash = hash;
+  cache->slot[i].bits = offset;
+  cache->slot[i].state = state;
+  cache->used++;
+}
+
+// adds the configuration, 0 if it was there already
+static int cacheadd(cache_t *cache, uint64_t hash, const uint64_t *bits, int state)
+{
+  long i;
+
+  for (i = hash&(cache->slots-1); cache->slot[i].hash != 0; i = (i+1)&(cache->slots-1)) {
+    if (cache->slot[i].hash == hash && cache->slot[i].state == state &&
+        memcmp(cache->arena+cache->slot[i].bits, bits, cache->words*sizeof(uint64_t)) == 0)
+      return 0;
+  }
+  cacheput(cache, hash, bits, state, 0);
+  return 1;
+}
+
+static uint64_t mix(uint64_t x)
+{
+  x ^= x>>33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x>>33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x>>33;
+  return x|1; // not 0
+}
+
+// the result of op in state, and the next state
+static int step(int op, int *state)
+{
+  int res;
+
+  switch (op) {
+  case HIST_ADD: res = !*state; *state = 1; return res;
+  case HIST_REM: res = *state; *state = 0; return res;
+  default:       return *state;
+  }
+}
+
+static void lift(entry_t *call)
+{
+  call->prev->next = call->next;
+  call->next->prev = call->prev;
+  call->match->prev->next = call->match->next;
+  call->match->next->prev = call->match->prev;
+}
+
+static void unlift(entry_t *call)
+{
+  call->match->prev->next = call->match;
+  call->match->next->prev = call->match;
+  call->prev->next = call;
+  call->next->prev = call;
+}
+
+// 1 linearizable, 0 not, -1 unknown
+static int checkkey(const event_t *event, long m, int present)
+{
+  entry_t *entries, **order, head, *entry, *call;
+  entry_t **stack;
+  int *states;
+  uint64_t *bits, hash, *zobrist;
+  cache_t cache;
+  long i, top, steps;
+  int state, next, res, verdict;
+  int words = (int)((m+63)/64);
+
+  entries = (entry_t*)malloc(2*m*sizeof(entry_t));
+  order = (entry_t**)malloc(2*m*sizeof(entry_t*));
+  stack = (entry_t**)malloc(m*sizeof(entry_t*));
+  states = (int*)malloc(m*sizeof(int));
+  bits = (uint64_t*)calloc(words, sizeof(uint64_t));
+  zobrist = (uint64_t*)malloc(m*sizeof(uint64_t));
+  assert(entries != NULL && order != NULL && stack != NULL && states != NULL && bits != NULL && zobrist != NULL);
+
+  for (i = 0; i < m; i++) {
+    entries[2*i].time = event[i].invoke;
+    entries[2*i].ret = 0;
+    entries[2*i].op = (int)i;
+    entries[2*i].match = &entries[2*i+1];
+    entries[2*i+1].time = event[i].response;
+    entries[2*i+1].ret = 1;
+    entries[2*i+1].op = (int)i;
+    entries[2*i+1].match = NULL;
+    order[2*i] = &entries[2*i];
+    order[2*i+1] = &entries[2*i+1];
+    zobrist[i] = mix((uint64_t)i+0x9E3779B97F4A7C15ULL);
+  }
+  qsort(order, 2*m, sizeof(entry_t*), bytime);
+  head.prev = head.next = &head;
+  for (i = 2*m-1; i >= 0; i--) {
+    order[i]->next = head.next;
+    order[i]->prev = &head;
+    head.next->prev = order[i];
+    head.next = order[i];
+  }
+  cacheinit(&cache, words);
+
+  state = present;
+  hash = 0;
+  top = 0;
+  steps = 0;
+  verdict = 1;
+  entry = head.next;
+  while (head.next != &head) {
+    if (++steps > HISTSTEPS) {
+      verdict = -1;
+      break;
+    }
+    if (!entry->ret) {
+      call = entry;
+      next = state;
+      res = step(event[call->op].op, &next);
+      bits[call->op/64] |= 1ULL<<(call->op%64);
+      if (res == event[call->op].res && cacheadd(&cache, mix(hash^zobrist[call->op]^(uint64_t)next), bits, next)) {
+        stack[top] = call;
+        states[top++] = state;
+        hash ^= zobrist[call->op];
+        state = next;
+        lift(call);
+        entry = head.next;
+      } else {
+        bits[call->op/64] &= ~(1ULL<<(call->op%64));
+        entry = entry->next;
+      }
+    } else {
+      // the operation of this return can not be linearized: backtrack
+      if (top == 0) {
+        verdict = 0;
+        break;
+      }
+      call = stack[--top];
+      state = states[top];
+      hash ^= zobrist[call->op];
+      bits[call->op/64] &= ~(1ULL<<(call->op%64));
+      unlift(call);
+      entry = call->next;
+    }
+  }
+
+  cachefree(&cache);
+  free(entries);
+  free(order);
+  free(stack);
+  free(states);
+  free(bits);
+  free(zobrist);
+  return verdict;
+}
+
+void histcheck(history_t *hist, verdict_t *verdict, FILE *report)
+{
+  long i, j, k, init;
+  int present, res;
+
+  qsort(hist->event, hist->n, sizeof(event_t), bykey);
+  qsort(hist->init, hist->ninit, sizeof(long), bylong);
+  verdict->ops = hist->n;
+  verdict->keys = 0;
+  verdict->violations = 0;
+  verdict->unknown = 0;
+  init = 0;
+  for (i = 0; i < hist->n; i = j) {
+    for (j = i+1; j < hist->n && hist->event[j].key == hist->event[i].key; j++);
+    while (init < hist->ninit && hist->init[init] < hist->event[i].key)
+      init++;
+    present = init < hist->ninit && hist->init[init] == hist->event[i].key;
+    verdict->keys++;
+    res = checkkey(&hist->event[i], j-i, present);
+    if (res == 1)
+      continue;
+    if (res < 0) {
+      verdict->unknown++;
+      if (report != NULL)
+        fprintf(report, "Key %ld: %ld operations, no verdict after %ld steps\n", hist->event[i].key, j-i, HISTSTEPS);
+      continue;
+    }
+    verdict->violations++;
+    if (report != NULL) {
+      fprintf(report, "Key %ld: not linearizable, %s at the start\n", hist->event[i].key, present ? "present" : "absent");
+      for (k = i; k < j && k < i+64; k++)
+        fprintf(report, "  thread %d %s %d [%llu,%llu]\n", hist->event[k].thread, histnames[hist->event[k].op],
+                hist->event[k].res, hist->event[k].invoke, hist->event[k].response);
+      if (j-i > 64)
+        fprintf(report, "  ...\n");
+    }
+  }
+}
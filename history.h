@@ -0,0 +1,71 @@
+/* Recorded histories of set operations and their linearizability check */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HIST_ADD 0
+#define HIST_REM 1
+#define HIST_CON 2
+
+#define HISTSTEPS 100000000L // search steps per key before giving up
+
+extern const char *histnames[];
+
+typedef struct _event {
+  long key;
+  unsigned long long invoke, response; // ns, the same clock for all threads
+  int op, res, thread;
+} event_t;
+
+typedef struct _history {
+  event_t *event;
+  long n, size;
+  long *init;       // keys present at the start
+  long ninit;
+} history_t;
+
+typedef struct _verdict {
+  long ops, keys;
+  long violations;  // keys without a linearization
+  long unknown;     // keys given up after HISTSTEPS
+} verdict_t;
+
+unsigned long long histnow(void);
+void histinit(history_t *hist, long size);
+void histfree(history_t *hist);
+void histappend(history_t *hist, const history_t *other); // events of other
+void histstart(history_t *hist, const long keys[], long n); // present at the start
+int histwrite(const history_t *hist, FILE *file);
+int histread(history_t *hist, FILE *file); // 0 if malformed
+
+// per key, which is exact for sets (locality of linearizability);
+// the operations of violating keys are written to report
+void histcheck(history_t *hist, verdict_t *verdict, FILE *report);
+
+static inline void histlog(history_t *hist, int op, long key, int res, int thread,
+                           unsigned long long invoke, unsigned long long response)
+{
+  event_t *e;
+
+  if (hist->n == hist->size)
+    return;
+  e = &hist->event[hist->n++];
+  e->key = key;
+  e->op = op;
+  e->res = res;
+  e->thread = thread;
+  e->invoke = invoke;
+  e->response = response;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
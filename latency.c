@@ -0,0 +1,124 @@
+/* Per thread latency histograms of sampled operations (HDR-style, log-bucketed) */
+
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+
+int latperiod = 16;
+
+static double nspertick = 1.0;
+
+static double wallns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1e9+ts.tv_nsec;
+}
+
+// ticks of the time stamp counter against the wall clock, over 10ms
+void latcalibrate(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned long long t0, t1;
+  double w0, w1;
+
+  w0 = wallns();
+  t0 = latnow();
+  do {
+    w1 = wallns();
+  } while (w1-w0 < 1e7);
+  t1 = latnow();
+  nspertick = (w1-w0)/(t1-t0);
+#endif
+}
+
+void latinit(latency_t *lat)
+{
+  memset(lat, 0, sizeof(latency_t));
+  lat->seed = ((unsigned long long)(uintptr_t)lat*0x9E3779B97F4A7C15ULL)|1; // per thread
+  if (latperiod > 0)
+    lat->next = latgap(lat);
+}
+
+static inline int bucket(unsigned long long v)
+{
+  int e;
+
+  if (v < LATSUB)
+    return (int)v;
+  e = 63-__builtin_clzll(v); // >= 4
+  return LATSUB+(e-4)*LATSUB+(int)((v>>(e-4))-LATSUB);
+}
+
+// the largest value of bucket b
+static unsigned long long highest(int b)
+{
+  int e, sub;
+
+  if (b < LATSUB)
+    return b;
+  e = (b-LATSUB)/LATSUB+4;
+  sub = (b-LATSUB)%LATSUB;
+  return ((unsigned long long)(LATSUB+sub+1)<<(e-4))-1;
+}
+
+void latrecord(latency_t *lat, int op, unsigned long long ticks)
+{
+  lat->count[op][bucket(ticks)]++;
+  if (ticks > lat->max[op])
+    lat->max[op] = ticks;
+}
+
+void latmerge(latency_t *into, latency_t *from)
+{
+  int op, b;
+
+  for (op = 0; op < LATOPS; op++) {
+    for (b = 0; b < LATBUCKETS; b++)
+      into->count[op][b] += from->count[op][b];
+    if (from->max[op] > into->max[op])
+      into->max[op] = from->max[op];
+  }
+}
+
+unsigned long long latsamples(latency_t *lat, int op)
+{
+  unsigned long long n;
+  int b;
+
+  n = 0;
+  for (b = 0; b < LATBUCKETS; b++)
+    n += lat->count[op][b];
+  return n;
+}
+
+// the highest value equivalent to the sample at rank ceil(q*n), at most the maximum
+double latpercentile(latency_t *lat, int op, double q)
+{
+  unsigned long long n, rank, seen, v;
+  int b;
+
+  n = latsamples(lat, op);
+  if (n == 0)
+    return 0.0;
+  rank = (unsigned long long)(q*n);
+  if (rank < q*n || rank < 1)
+    rank++;
+  seen = 0;
+  for (b = 0; b < LATBUCKETS; b++) {
+    seen += lat->count[op][b];
+    if (seen >= rank)
+      break;
+  }
+  v = highest(b);
+  if (v > lat->max[op])
+    v = lat->max[op];
+  return v*nspertick;
+}
+
+double latmax(latency_t *lat, int op)
+{
+  return lat->max[op]*nspertick;
+}
@@ -0,0 +1,84 @@
+/* Per thread latency histograms of sampled operations (HDR-style, log-bucketed) */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define LAT_ADD 0
+#define LAT_REM 1
+#define LAT_CON 2
+#define LATOPS  3
+
+// values below LATSUB exact, above with LATSUB sub-buckets per power of
+// two, i.e., less than 1/LATSUB relative error
+#define LATSUB     16
+#define LATBUCKETS ((64-3)*LATSUB)
+
+extern int latperiod; // one in latperiod operations on average is timed, 0 for none
+
+typedef struct _latency {
+  unsigned long long count[LATOPS][LATBUCKETS]; // in ticks
+  unsigned long long max[LATOPS];
+  unsigned long long start; // of the operation being timed
+  int next;                 // operations until the next timed one
+  unsigned long long seed;  // of the gaps between timed operations
+} latency_t;
+
+void latcalibrate(void); // once, before timing
+void latinit(latency_t *lat);
+void latrecord(latency_t *lat, int op, unsigned long long ticks);
+void latmerge(latency_t *into, latency_t *from);
+unsigned long long latsamples(latency_t *lat, int op);
+double latpercentile(latency_t *lat, int op, double q); // in ns, q in [0,1]
+double latmax(latency_t *lat, int op);                  // in ns
+
+static inline unsigned long long latnow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+#endif
+}
+
+// operations until the next timed one, uniform in [1,2*latperiod-1]: a
+// random gap, so that no fixed pattern of operations is sampled with bias
+static inline int latgap(latency_t *lat)
+{
+  lat->seed ^= lat->seed>>12; // xorshift64*
+  lat->seed ^= lat->seed<<25;
+  lat->seed ^= lat->seed>>27;
+  return 1+(int)(((lat->seed*0x2545F4914F6CDD1DULL)>>33)%(2*latperiod-1));
+}
+
+// whether the next operation is timed, then from its start
+static inline int latbegin(latency_t *lat)
+{
+  if (latperiod == 0 || --lat->next > 0)
+    return 0;
+  lat->next = latgap(lat);
+  lat->start = latnow();
+  return 1;
+}
+
+// after the timed operation, with its result
+static inline int latend(latency_t *lat, int op, int res)
+{
+  latrecord(lat, op, latnow()-lat->start);
+  return res;
+}
+
+// the value of expression _e, timed as an operation _op if sampled
+#define TIMED(_l,_op,_e) (latbegin(_l) ? latend(_l,_op,(_e)) : (_e))
+
+#endif
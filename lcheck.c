@@ -0,0 +1,36 @@
+/* Offline linearizability check of a history written by listbench -B H -y <file> */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "history.h"
+
+int main(int argc, char *argv[])
+{
+  history_t hist;
+  verdict_t verdict;
+  FILE *file;
+  double start;
+  int ok;
+
+  file = (argc > 1) ? fopen(argv[1], "r") : stdin;
+  if (file == NULL) {
+    fprintf(stderr, "Cannot open %s\n", argv[1]);
+    return 2;
+  }
+  ok = histread(&hist, file);
+  if (file != stdin)
+    fclose(file);
+  if (!ok) {
+    fprintf(stderr, "Malformed history, after %ld operations\n", hist.n);
+    return 2;
+  }
+
+  start = histnow();
+  histcheck(&hist, &verdict, stdout);
+  printf("History: %ld operations on %ld keys, %ld not linearizable, %ld unknown (%.2f s)\n",
+         verdict.ops, verdict.keys, verdict.violations, verdict.unknown, (histnow()-start)/1e9);
+  histfree(&hist);
+
+  return (verdict.violations > 0) ? 1 : 0;
+}
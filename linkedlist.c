@@ -1,294 +1,1962 @@
-/* (C) Jesper Larsson Traff, May 2020, October 2020 */
-/* Improved lock-free linked list implementations */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <limits.h>
-
-#include <stdatomic.h> // gcc -latomic 
-
-#include <assert.h>
-
-#include "linkedlist.h"
-
-//#define DOUBLY
-//#define CURSOR / only with DOUBLY
-//#define TEXTBOOK
-//#define FETCH
-
-// Memory model
-//#define SC
-
-#define UNMARK_MASK ~1
-#define MARK_BIT 0x0000000000001
-
-#define getpointer(_markedpointer)  ((node_t*)(((long)_markedpointer) & UNMARK_MASK))
-#define ismarked(_markedpointer)    ((((long)_markedpointer) & MARK_BIT) != 0x0)
-#define setmark(_markedpointer)     ((node_t*)(((long)_markedpointer) | MARK_BIT))
-
-#ifdef SC
-#define CAS(_a,_e,_d) atomic_compare_exchange_weak(_a,_e,_d)
-#define LOAD(_a)      atomic_load(_a)
-#define STORE(_a,_e)  atomic_store(_a,_e)
-#define FAO(_a,_e)    atomic_fetch_or(_a,_e)
-#else
-#define CAS(_a,_e,_d) atomic_compare_exchange_weak_explicit(_a,_e,_d,memory_order_acq_rel,memory_order_acquire)
-#define LOAD(_a)      atomic_load_explicit(_a,memory_order_acquire)
-#define STORE(_a,_e)  atomic_store_explicit(_a,_e,memory_order_release)
-#define FAO(_a,_e)    atomic_fetch_or_explicit(_a,_e,memory_order_acq_rel)
-#endif
-
-void init(node_t *head, node_t *tail, list_t *list)
-{
-  list->head = head;
-  list->tail = tail;
-
-  // the sentinels
-  list->head->key = LONG_MIN;
-  list->head->next = tail;
-  list->head->prev = NULL;
-
-  list->tail->key = LONG_MAX;
-  list->tail->next = NULL;
-  list->tail->prev = head;
-
-  list->pred = head;
-  list->curr = NULL;
-
-  list->free = NULL;
-
-#ifdef COUNTERS
-  list->adds = 0;
-  list->rems = 0;
-  list->cons = 0;
-  list->trav = 0;
-  list->fail = 0;
-  list->rtry = 0;
-#endif
-}
-
-void clean(list_t *list)
-{
-  node_t *next, *node;
-
-  next = list->free;
-  while (next != NULL) {
-    node = next;
-    next = next->free;
-    free(node);
-  }
-  list->free = NULL;
-}
-
-void pos(long key, list_t *list)
-{
-  node_t *pred, *succ, *curr, *next;
-
-#ifdef DOUBLY
-#ifdef CURSOR
-  pred = list->pred;
-#else
-  pred = list->pred;
-  if (key <= pred->key)
-    pred = list->head;
-#endif
-
-retry:
-  while (ismarked(LOAD(&pred->next)) || key <= pred->key) {
-    INC(list->trav);
-    pred = LOAD(&pred->prev);
-  }
-  curr = getpointer(LOAD(&pred->next));
-  INC(list->trav);
-#else // DOUBLY
-retry:
-#ifdef TEXTBOOK
-  pred = list->head;
-#else
-  pred = list->pred;
-  if (ismarked(LOAD(&pred->next)) || key <= pred->key)
-    pred = list->head;
-#endif
-
-  curr = getpointer(LOAD(&pred->next));
-  INC(list->trav);
-#endif // DOUBLY
-  assert(pred->key < key);
-
-  do {
-    succ = LOAD(&curr->next);
-    while (ismarked(succ)) {
-      succ = getpointer(succ);
-      if (!CAS(&pred->next, &curr, succ)) {
-        INC(list->fail);
-#ifdef TEXTBOOK
-        INC(list->rtry);
-        goto retry;
-#else
-        next = LOAD(&pred->next);
-        if (ismarked(next)) {
-          INC(list->rtry);
-          goto retry;
-        }
-        succ = next;
-#endif
-      }
-#ifdef DOUBLY
-      else
-        STORE(&succ->prev, pred);
-#endif
-
-      curr = getpointer(succ);
-      succ = LOAD(&succ->next);
-      INC(list->trav);
-    }
-#ifdef DOUBLY
-    if (LOAD(&curr->prev) != pred)
-      STORE(&curr->prev, pred);
-#endif
-
-    if (key <= curr->key) {
-      assert(pred->key < curr->key);
-      list->pred = pred;
-      list->curr = curr;
-      return;
-    }
-    pred = curr;
-    curr = getpointer(LOAD(&curr->next));
-    INC(list->trav);
-  } while (1);
-}
-
-int add(long key, list_t *list)
-{
-  node_t *pred, *curr, *node;
-
-  node = (node_t*)malloc(sizeof(node_t));
-  assert(node != NULL);
-  node->key = key;
-
-#ifndef CURSOR
-  list->pred = list->head;
-#endif
-  do {
-    pos(key, list);
-    pred = list->pred;
-    curr = list->curr;
-    if (curr->key == key) {
-      free(node);
-      return 0; // already there
-    }
-
-    node->next = curr;
-#ifdef DOUBLY
-    node->prev = pred;
-#endif
-
-    if (CAS(&pred->next, &curr, node)) {
-      INC(list->adds);
-#ifdef DOUBLY
-      STORE(&curr->prev, node);
-#endif
-
-      return 1;
-    }
-    INC(list->fail);
-  } while (1);
-}
-
-int rem(long key, list_t *list)
-{
-  node_t *pred, *succ, *node;
-  node_t *markedsucc;
-
-  do {
-    pos(key, list);
-    pred = list->pred;
-    node = list->curr;
-    if (node->key != key)
-      return 0; // not there
-
-#ifdef TEXTBOOK
-    succ = getpointer(LOAD(&node->next)); // unmarked
-    markedsucc = setmark(succ);
-
-    if (!CAS(&node->next, &succ, markedsucc)) {
-      INC(list->fail);
-      continue;
-    }
-#else
-#ifdef FETCH
-    // x86 supports atomic-or, but not atomic-fetch-or, i.e., we cannot get the old value.
-    // If we do not use the return value of the fetch-or, the compiler is smart enough to
-    // use an atomic-or. If we use the return value, the atomic-fetch-or is emulated via
-    // a CAS loop.
-    // In this case it would be sufficient to use a pure atomic-or, although it has the
-    // drawback that we cannot tell WHO has set the bit, so we would also have to adapt
-    // the management of the free-list.
-
-    succ = (node_t*)FAO((_Atomic uint64_t*)&node->next, MARK_BIT);
-    if (ismarked(succ)) return 0;
-#else    
-    succ = LOAD(&node->next);
-    do {
-      if (ismarked(succ))
-        return 0;
-      markedsucc = setmark(succ);
-      if (CAS(&node->next, &succ, markedsucc))
-        break;
-      INC(list->fail);
-    } while (1);
-#endif
-#endif
-    
-    if (!CAS(&pred->next, &node, succ))
-      node = list->curr; // beware!
-#ifdef DOUBLY
-    STORE(&succ->prev, pred);
-#endif
-
-    node->free = list->free;
-    list->free = node;
-    INC(list->rems);
-
-    return 1;
-  } while (1);
-}
-
-int con(long key, list_t *list)
-{
-  node_t *curr;
-
-#ifdef DOUBLY
-#ifdef CURSOR
-  curr = list->pred;
-#else
-  curr = list->head;
-#endif
-  INC(list->cons);
-  while (key < curr->key) {
-    curr = LOAD(&curr->prev);
-    INC(list->cons);
-  }
-#else // DOUBLY
-#ifdef CURSOR
-  curr = list->pred;
-  if (key < curr->key)
-    curr = list->head;
-#else
-  curr = list->head;
-#endif
-#endif // DOUBLY
-  assert(curr->key <= key);
-
-  while (key > curr->key) {
-    curr = getpointer(LOAD(&curr->next));
-    INC(list->cons);
-  }
-
-#ifdef CURSOR
-  list->pred = curr;
-#endif
-
-  return (curr->key == key && !ismarked(LOAD(&curr->next)));
-}
+/* (C) Jesper Larsson Traff, May 2020, October 2020 */
+/* Improved lock-free linked list implementations */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include <stdatomic.h> // gcc -latomic 
+
+#include <assert.h>
+
+#include "linkedlist.h"
+
+//#define DOUBLY
+//#define CURSOR / only with DOUBLY
+//#define TEXTBOOK
+//#define FETCH
+//#define EPOCH // epoch-based reclamation of removed nodes
+//#define HAZARD // hazard pointer reclamation of removed nodes
+//#define SKIP // skip-list index over the list
+//#define SPLITORDER // split-ordered hash set over the list, with CURSOR
+//#define MAP // a value per key
+//#define FINGERS // several cursors per thread, with CURSOR
+
+// Memory model
+//#define SC
+
+#define UNMARK_MASK ~1
+#define MARK_BIT 0x0000000000001
+
+#ifdef LAYOUT_SPLIT
+static long minkey = LONG_MIN, maxkey = LONG_MAX;
+#define NODEFREE(_n,_l) (slabfree((_n)->key,&(_l)->keys),slabfree(_n,&(_l)->slab))
+#else
+#define NODEFREE(_n,_l) slabfree(_n,&(_l)->slab)
+#endif
+
+#define getpointer(_markedpointer)  ((node_t*)(((long)_markedpointer) & UNMARK_MASK))
+#define ismarked(_markedpointer)    ((((long)_markedpointer) & MARK_BIT) != 0x0)
+#define setmark(_markedpointer)     ((node_t*)(((long)_markedpointer) | MARK_BIT))
+
+#ifdef SC
+#define CAS(_a,_e,_d) atomic_compare_exchange_weak(_a,_e,_d)
+#define LOAD(_a)      atomic_load(_a)
+#define STORE(_a,_e)  atomic_store(_a,_e)
+#define FAO(_a,_e)    atomic_fetch_or(_a,_e)
+#else
+#define CAS(_a,_e,_d) atomic_compare_exchange_weak_explicit(_a,_e,_d,memory_order_acq_rel,memory_order_acquire)
+#define LOAD(_a)      atomic_load_explicit(_a,memory_order_acquire)
+#define STORE(_a,_e)  atomic_store_explicit(_a,_e,memory_order_release)
+#define FAO(_a,_e)    atomic_fetch_or_explicit(_a,_e,memory_order_acq_rel)
+#endif
+
+#if defined(EPOCH) || defined(HAZARD)
+#ifdef DOUBLY
+#error "EPOCH and HAZARD require a singly linked variant (prev pointers may refer to reclaimed nodes)"
+#endif
+#if defined(EPOCH) && defined(HAZARD)
+#error "EPOCH and HAZARD are alternatives"
+#endif
+
+#define MAXTHREADS 1024 // announcement slots
+
+#ifdef HAZARD
+#define HAZARDS  3 // hazard pointers per thread
+#define HPCURR   0
+#define HPPRED   1
+#define HPCURSOR 2 // keeps the cursor alive between operations
+#endif
+
+typedef struct {
+  _Alignas(64) _Atomic(int) used;
+#ifdef EPOCH
+  // announced epoch shifted left by one, lowest bit set while in an operation
+  _Atomic(unsigned long) epoch;
+#else
+  _Atomic(node_t*) hp[HAZARDS];
+#endif
+} slot_t;
+
+static _Atomic(int) slots = 0; // high water mark of used slots
+static slot_t slot[MAXTHREADS];
+
+static void acquireslot(list_t *list)
+{
+  int i, n;
+
+  for (i = 0; i < MAXTHREADS; i++) {
+    int unused = 0;
+    if (atomic_compare_exchange_strong(&slot[i].used, &unused, 1))
+      break;
+  }
+  assert(i < MAXTHREADS);
+  list->slot = i;
+
+  n = atomic_load(&slots);
+  while (n < i+1 && !atomic_compare_exchange_weak(&slots, &n, i+1));
+}
+
+static void releaseslot(list_t *list)
+{
+  atomic_store(&slot[list->slot].used, 0);
+}
+#endif
+
+#ifdef EPOCH
+#define ADVANCE    64   // retirements between attempts to advance the epoch
+
+static _Atomic(unsigned long) global = 0;
+
+static void reclaim(int i, list_t *list)
+{
+  node_t *next, *node;
+
+  next = list->limbo[i];
+  while (next != NULL) {
+    node = next;
+    next = next->free;
+    NODEFREE(node, list);
+  }
+  list->limbo[i] = NULL;
+}
+
+static void enter(list_t *list)
+{
+  unsigned long e, g;
+  int i;
+
+  g = atomic_load(&global);
+  do {
+    e = g;
+    atomic_store(&slot[list->slot].epoch, (e<<1)|1);
+    g = atomic_load(&global);
+  } while (g != e);
+
+  if (e != list->epoch) {
+    // nobody can reach nodes retired two or more epochs ago
+    for (i = 0; i < 3; i++)
+      if (list->limboepoch[i] + 2 <= e)
+        reclaim(i, list);
+    // the cursor is only known to be safe within the same epoch
+    list->pred = list->head;
+#ifdef FINGERS
+    for (i = 0; i < NFINGERS; i++)
+      list->fingers[i] = list->head;
+#endif
+    list->epoch = e;
+  }
+}
+
+static void quiesce(list_t *list)
+{
+  atomic_store_explicit(&slot[list->slot].epoch, list->epoch<<1,
+                        memory_order_release);
+}
+
+static void advance(list_t *list)
+{
+  unsigned long g, e;
+  int i, n;
+
+  g = atomic_load(&global);
+  n = atomic_load(&slots);
+  for (i = 0; i < n; i++) {
+    e = atomic_load(&slot[i].epoch);
+    if ((e & 1) && (e>>1) != g)
+      return; // some thread still in an older epoch
+  }
+  atomic_compare_exchange_strong(&global, &g, g+1);
+}
+
+// node has been unlinked by this thread
+static void retire(node_t *node, list_t *list)
+{
+  unsigned long e;
+  int i;
+
+  e = atomic_load(&global);
+  i = e % 3;
+  if (list->limboepoch[i] != e) {
+    assert(list->limbo[i] == NULL);
+    list->limboepoch[i] = e;
+  }
+  node->free = list->limbo[i];
+  list->limbo[i] = node;
+
+  if (++list->retired == ADVANCE) {
+    list->retired = 0;
+    advance(list);
+  }
+}
+#define ENTER(_l) enter(_l)
+#define LEAVE(_l) quiesce(_l)
+#elif defined(HAZARD)
+#define PROTECT(_i,_p) atomic_store(&slot[list->slot].hp[_i],_p)
+
+static int ptrcmp(const void *a, const void *b)
+{
+  node_t *x = *(node_t**)a;
+  node_t *y = *(node_t**)b;
+
+  return (x > y) - (x < y);
+}
+
+// free all retired nodes not protected by some thread
+static void scan(list_t *list)
+{
+  node_t *next, *node, *keep;
+  node_t **hazards = list->hazards;
+  int i, j, n, h;
+
+  h = 0;
+  n = atomic_load(&slots);
+  for (i = 0; i < n; i++)
+    for (j = 0; j < HAZARDS; j++) {
+      node = atomic_load(&slot[i].hp[j]);
+      if (node != NULL)
+        hazards[h++] = node;
+    }
+  qsort(hazards, h, sizeof(node_t*), ptrcmp);
+
+  keep = NULL;
+  list->retired = 0;
+  next = list->limbo;
+  while (next != NULL) {
+    node = next;
+    next = next->free;
+    if (bsearch(&node, hazards, h, sizeof(node_t*), ptrcmp) != NULL) {
+      node->free = keep;
+      keep = node;
+      list->retired++;
+    } else
+      NODEFREE(node, list);
+  }
+  list->limbo = keep;
+}
+
+// node has been unlinked by this thread; at most 2*HAZARDS per
+// thread (but at least 64) retired nodes are kept before scanning
+static void retire(node_t *node, list_t *list)
+{
+  int bound;
+
+  node->free = list->limbo;
+  list->limbo = node;
+
+  bound = 2*HAZARDS*atomic_load_explicit(&slots, memory_order_relaxed);
+  if (bound < 64)
+    bound = 64;
+  if (++list->retired >= bound)
+    scan(list);
+}
+#define ENTER(_l)
+#define LEAVE(_l) atomic_store_explicit(&slot[(_l)->slot].hp[HPCURR],NULL,memory_order_release)
+#else
+#define ENTER(_l)
+#define LEAVE(_l)
+#endif
+
+// contention management: after a failed CAS, and at the start of updates
+#define BACKOFFCAS(_l) backoff(&(_l)->backoff)
+#ifdef COUNTERS
+#define BACKOFFSTART(_l) backoffstart(&(_l)->backoff,(_l)->fail+(_l)->rtry)
+#else
+#define BACKOFFSTART(_l) backoffstart(&(_l)->backoff,0)
+#endif
+
+#ifdef MAP
+#if defined(SPLITORDER) || defined(FETCH)
+#error "MAP is not combined with SPLITORDER or FETCH"
+#endif
+
+// The value of a removed key is first replaced by TOMBSTONE, which makes
+// the removal take effect, before the node is marked. A node with a
+// tombstone is thus absent to all operations, and operations that have to
+// insert the key help marking it, so that pos() unlinks it.
+#define TOMBSTONE LONG_MIN
+
+static void mark(node_t *node)
+{
+  node_t *succ;
+
+  succ = LOAD(&node->next);
+  while (!ismarked(succ) && !CAS(&node->next, &succ, setmark(succ)));
+}
+#endif // MAP
+
+#ifdef SPLITORDER
+#if defined(DOUBLY) || defined(TEXTBOOK) || !defined(CURSOR)
+#error "the split-ordered hash set starts from bucket sentinels, i.e., requires the singly linked list with CURSOR"
+#endif
+#if defined(EPOCH) || defined(HAZARD) || defined(SKIP)
+#error "the split-ordered hash set is not combined with reclamation or the skip-list index"
+#endif
+
+// the list operations, on split-order keys, for the hash set at the end
+#define add(_k,_l) listadd(_k,_l)
+#define rem(_k,_l) listrem(_k,_l)
+#define con(_k,_l) listcon(_k,_l)
+
+#define LOADFACTOR 2 // keys per bucket before the table doubles
+#define SEGMENTS   64
+#define FLUSH      64 // key count changes kept private
+
+// segment s > 0 holds the 2^s buckets with highest bit s, segment 0 buckets 0 and 1
+typedef struct _hash {
+  _Atomic(unsigned long) size; // number of buckets, a power of two
+  _Atomic long count;          // number of keys, up to FLUSH per thread behind
+  _Atomic(_Atomic(node_t *) *) segment[SEGMENTS];
+} hash_t;
+#endif // SPLITORDER
+
+#ifdef COMBINE
+#if !defined(CURSOR) || defined(TEXTBOOK) || defined(MAP) || defined(SPLITORDER)
+#error "COMBINE applies the published operations in one sorted pass from the cursor of the combiner"
+#endif
+#ifndef COUNTERS
+#error "COMBINE switches on the fail and rtry counters"
+#endif
+
+#include <sched.h>
+
+// the list operations, for the contention-adaptive ones at the end
+#define add(_k,_l) directadd(_k,_l)
+#define rem(_k,_l) directrem(_k,_l)
+
+#define PUBLICATIONS 1024 // threads per list
+
+typedef struct {
+  _Alignas(64) _Atomic(int) state; // IDLE, ADD, REM or DONE
+  long key;
+  int res;
+} pub_t;
+
+typedef struct _comb {
+  _Atomic(int) lock;
+  _Atomic(int) records; // publication records in use
+  pub_t pub[PUBLICATIONS];
+} comb_t;
+
+typedef struct {
+  long key;
+  int op, pub;
+} req_t;
+#endif // COMBINE
+
+#ifdef SKIP
+#if defined(DOUBLY) || defined(CURSOR) || defined(TEXTBOOK)
+#error "the skip-list index replaces cursor and backward pointers"
+#endif
+#if defined(EPOCH) || defined(HAZARD)
+#error "index nodes may refer to removed nodes, which are only released by clean()"
+#endif
+
+// Index levels above the list, as in the Java ConcurrentSkipListMap: each
+// level is a sorted singly linked list of index nodes, which refer to a
+// list node and to the index node of the level below. The index is only a
+// hint for where to start pos(). Index nodes of removed list nodes are
+// unlinked by whoever passes them; an index node linked after one that is
+// being unlinked may get lost, which costs a shortcut, but does not break
+// the order of a level.
+
+#define MAXLEVEL 32
+
+typedef struct _index {
+  _Atomic(struct _index *) right;
+  struct _index *down;
+  node_t *node;
+} index_t;
+
+typedef struct _skip {
+  _Atomic int level;       // number of levels in use
+  index_t heads[MAXLEVEL]; // first index node of each level, on head
+} skip_t;
+
+// Descend the index to the last node with a key smaller than key. The last
+// index node before key on the levels below levels is recorded in preds.
+static node_t *descend(long key, index_t **preds, int levels, list_t *list)
+{
+  skip_t *skip;
+  index_t *p, *q, *r;
+  int i;
+
+  skip = (skip_t*)list->head->aux;
+  i = LOAD(&skip->level)-1;
+  p = &skip->heads[i];
+  do {
+    q = LOAD(&p->right);
+    while (q != NULL) {
+      if (ismarked(LOAD(&q->node->next))) {
+        r = LOAD(&q->right);
+        if (CAS(&p->right, &q, r))
+          q = r;
+        else
+          INC(list->fail);
+        INC(list->trav);
+        continue;
+      }
+      if (key <= KEY(q->node))
+        break;
+      p = q;
+      q = LOAD(&q->right);
+      INC(list->trav);
+    }
+    if (i < levels)
+      preds[i] = p;
+    if (i == 0)
+      return p->node;
+    p = p->down;
+    i--;
+  } while (1);
+}
+
+// number of index levels for a new node, geometric with p = 1/2
+static int height(list_t *list)
+{
+  unsigned long x;
+  int h;
+
+  x = list->seed; // xorshift
+  x ^= x<<13;
+  x ^= x>>7;
+  x ^= x<<17;
+  list->seed = x;
+
+  h = (~x == 0) ? MAXLEVEL : __builtin_ctzl(~x);
+  return (h < MAXLEVEL) ? h : MAXLEVEL;
+}
+
+// link the newly added node into the h lowest levels, bottom up; gives up
+// once the node has been removed
+static void build(node_t *node, int h, list_t *list)
+{
+  skip_t *skip;
+  index_t *preds[MAXLEVEL];
+  index_t *p, *q, *idx, *down;
+  long key;
+  int i, level;
+
+  skip = (skip_t*)list->head->aux;
+  level = LOAD(&skip->level);
+  while (level < h && !CAS(&skip->level, &level, h));
+
+  key = KEY(node);
+  descend(key, preds, h, list);
+
+  down = NULL;
+  for (i = 0; i < h; i++) {
+    idx = (index_t*)slaballoc(&list->index);
+    idx->node = node;
+    idx->down = down;
+
+    p = preds[i];
+    do {
+      if (ismarked(LOAD(&node->next))) {
+        slabfree(idx, &list->index);
+        return;
+      }
+      q = LOAD(&p->right);
+      while (q != NULL && KEY(q->node) < key) {
+        p = q;
+        q = LOAD(&q->right);
+        INC(list->trav);
+      }
+      idx->right = q;
+      if (CAS(&p->right, &q, idx))
+        break;
+      INC(list->fail);
+    } while (1);
+    down = idx;
+  }
+}
+#endif // SKIP
+
+#ifdef FINGERS
+#if !defined(CURSOR) || defined(DOUBLY) || defined(TEXTBOOK) || defined(HAZARD) || defined(SKIP) || defined(SPLITORDER)
+#error "FINGERS replaces the cursor of the singly linked list with CURSOR"
+#endif
+#ifndef COUNTERS
+#error "FINGERS counts the hops with the trav and cons counters"
+#endif
+
+#define FINGERHOPS 32 // farther from the finger, a new region
+#define FINGERAGE  64 // operations a finger must be unused to be replaced
+
+// The unmarked finger with the largest key below key, else the head;
+// marked fingers are dropped
+static node_t *finger(long key, list_t *list)
+{
+  node_t *best;
+  int i, f;
+
+  do {
+    best = list->head;
+    f = -1;
+    for (i = 0; i < NFINGERS; i++) {
+      if (KEY(list->fingers[i]) < key && KEY(list->fingers[i]) > KEY(best)) {
+        best = list->fingers[i];
+        f = i;
+      }
+    }
+    if (f < 0 || !ismarked(LOAD(&best->next)))
+      break;
+    list->fingers[f] = list->head;
+  } while (1);
+  list->finger = f;
+  list->hops = list->trav+list->cons;
+  list->ops++;
+  if (f >= 0)
+    list->used[f] = list->ops;
+
+  return best;
+}
+
+// fingers a and b are in the same region, closer than FINGERHOPS at the
+// key density of the last long walk
+static inline int close(node_t *a, node_t *b, list_t *list)
+{
+  return (double)(KEY(b)-KEY(a)) < FINGERHOPS*list->density;
+}
+
+// The operation ended at node. Fingers only move down, to the start of
+// their region: after a long walk, node is in a region without a finger
+// below it, and the finger above node moves down to it if it is in the same
+// region. Otherwise node replaces an unused finger, one in the same region
+// as a lower one, or the least recently used one if that is stale.
+static void remember(node_t *node, list_t *list)
+{
+  unsigned long long walk;
+  node_t *from;
+  int i, j, a, b, lru;
+
+  walk = list->trav+list->cons-list->hops;
+  if (walk <= FINGERHOPS)
+    return;
+
+  if (list->finger >= 0) {
+    from = list->fingers[list->finger];
+    list->density = (double)(KEY(node)-KEY(from))/walk;
+  }
+
+  a = -1;
+  for (i = 0; i < NFINGERS; i++) {
+    if (list->fingers[i] == list->head) {
+      list->fingers[i] = node;
+      list->used[i] = list->ops;
+      return;
+    }
+    if (KEY(list->fingers[i]) > KEY(node) && (a < 0 || KEY(list->fingers[i]) < KEY(list->fingers[a])))
+      a = i;
+  }
+  if (a >= 0 && close(node, list->fingers[a], list)) {
+    list->fingers[a] = node;
+    list->used[a] = list->ops;
+    return;
+  }
+  for (i = 0; i < NFINGERS; i++) {
+    b = -1; // the finger below i
+    for (j = 0; j < NFINGERS; j++)
+      if (KEY(list->fingers[j]) < KEY(list->fingers[i]) && (b < 0 || KEY(list->fingers[j]) > KEY(list->fingers[b])))
+        b = j;
+    if (b >= 0 && close(list->fingers[b], list->fingers[i], list)) {
+      list->fingers[i] = node;
+      list->used[i] = list->ops;
+      return;
+    }
+  }
+  lru = 0;
+  for (i = 1; i < NFINGERS; i++)
+    if (list->used[i] < list->used[lru])
+      lru = i;
+  if (list->ops-list->used[lru] > FINGERAGE) {
+    list->fingers[lru] = node;
+    list->used[lru] = list->ops;
+  }
+}
+#endif // FINGERS
+
+void create(node_t *head, node_t *tail)
+{
+  // the sentinels
+#ifdef LAYOUT_SPLIT
+  head->key = &minkey;
+  tail->key = &maxkey;
+#else
+  head->key = LONG_MIN;
+  tail->key = LONG_MAX;
+#endif
+  head->next = tail;
+  tail->next = NULL;
+#if !defined(LAYOUT_DENSE) || defined(DOUBLY)
+  head->prev = NULL;
+  tail->prev = head;
+#endif
+#ifdef MAP
+  head->value = 0;
+  tail->value = 0;
+#endif
+
+#ifdef SPLITORDER
+  hash_t *hash;
+  int i;
+
+  hash = (hash_t*)malloc(sizeof(hash_t));
+  assert(hash != NULL);
+  hash->size = 2;
+  hash->count = 0;
+  for (i = 0; i < SEGMENTS; i++)
+    hash->segment[i] = NULL;
+  hash->segment[0] = (_Atomic(node_t*)*)calloc(2, sizeof(_Atomic(node_t*)));
+  assert(hash->segment[0] != NULL);
+  hash->segment[0][0] = head; // the sentinel of bucket 0
+  head->aux = hash;
+#endif
+#ifdef SKIP
+  skip_t *skip;
+  int i;
+
+  skip = (skip_t*)malloc(sizeof(skip_t));
+  assert(skip != NULL);
+  skip->level = 1;
+  for (i = 0; i < MAXLEVEL; i++) {
+    skip->heads[i].right = NULL;
+    skip->heads[i].down = (i > 0) ? &skip->heads[i-1] : NULL;
+    skip->heads[i].node = head;
+  }
+  head->aux = skip;
+#endif
+#ifdef COMBINE
+  comb_t *comb;
+  int i;
+
+  comb = (comb_t*)aligned_alloc(64, sizeof(comb_t));
+  assert(comb != NULL);
+  comb->lock = 0;
+  comb->records = 0;
+  for (i = 0; i < PUBLICATIONS; i++)
+    comb->pub[i].state = 0;
+  head->aux = comb;
+#endif
+}
+
+void destroy(node_t *head, node_t *tail)
+{
+#ifdef SPLITORDER
+  hash_t *hash;
+  int i;
+
+  hash = (hash_t*)head->aux;
+  for (i = 0; i < SEGMENTS; i++)
+    free(hash->segment[i]); // the bucket sentinels are released by clean()
+  free(hash);
+#endif
+#ifdef SKIP
+  free(head->aux); // the index nodes are released by clean()
+#endif
+#ifdef COMBINE
+  free(head->aux);
+#endif
+}
+
+void init(node_t *head, node_t *tail, list_t *list)
+{
+  list->head = head;
+  list->tail = tail;
+
+  list->pred = head;
+  list->curr = NULL;
+#ifdef FINGERS
+  int f;
+  for (f = 0; f < NFINGERS; f++) {
+    list->fingers[f] = head;
+    list->used[f] = 0;
+  }
+  list->finger = -1;
+  list->ops = 0;
+  list->density = 0.0;
+#endif
+
+  slabinit(&list->slab, sizeof(node_t));
+  backoffinit(&list->backoff);
+  list->shard = &list->own;
+  list->own.adds = 0;
+  list->own.rems = 0;
+#ifdef LAYOUT_SPLIT
+  slabinit(&list->keys, sizeof(long));
+#endif
+#ifdef SPLITORDER
+  list->delta = 0;
+#endif
+#ifdef SKIP
+  slabinit(&list->index, sizeof(index_t));
+  list->seed = 0x9E3779B97F4A7C15UL^(unsigned long)list;
+#endif
+#ifdef COMBINE
+  list->pub = atomic_fetch_add(&((comb_t*)head->aux)->records, 1);
+  assert(list->pub < PUBLICATIONS);
+  list->combining = 0;
+  list->window = 0;
+  list->wfail = 0;
+  list->wpubs = 0;
+  list->whits = 0;
+  list->reqs = malloc(PUBLICATIONS*sizeof(req_t));
+  assert(list->reqs != NULL);
+#endif
+
+#ifdef EPOCH
+  int i;
+  for (i = 0; i < 3; i++) {
+    list->limbo[i] = NULL;
+    list->limboepoch[i] = 0;
+  }
+  list->retired = 0;
+  acquireslot(list);
+  list->epoch = atomic_load(&global);
+  atomic_store(&slot[list->slot].epoch, list->epoch<<1);
+#endif
+#ifdef HAZARD
+  int i;
+  list->limbo = NULL;
+  list->retired = 0;
+  list->hazards = (node_t**)malloc(MAXTHREADS*HAZARDS*sizeof(node_t*));
+  assert(list->hazards != NULL);
+  acquireslot(list);
+  for (i = 0; i < HAZARDS; i++)
+    atomic_store(&slot[list->slot].hp[i], NULL);
+  atomic_store(&slot[list->slot].hp[HPCURSOR], head);
+#endif
+
+#ifdef COUNTERS
+  list->adds = 0;
+  list->rems = 0;
+  list->cons = 0;
+  list->trav = 0;
+  list->fail = 0;
+  list->rtry = 0;
+  list->upds = 0;
+  list->pubs = 0;
+  list->hits = 0;
+  list->elim = 0;
+#endif
+}
+
+void clean(list_t *list)
+{
+#ifdef EPOCH
+  atomic_store(&slot[list->slot].epoch, 0);
+  releaseslot(list);
+#endif
+#ifdef HAZARD
+  int i;
+  for (i = 0; i < HAZARDS; i++)
+    atomic_store(&slot[list->slot].hp[i], NULL);
+  free(list->hazards);
+  releaseslot(list);
+#endif
+
+  // at quiescence: list nodes, removed and retired nodes alike
+  slabrelease(&list->slab);
+#ifdef LAYOUT_SPLIT
+  slabrelease(&list->keys);
+#endif
+#ifdef SKIP
+  slabrelease(&list->index);
+#endif
+#ifdef COMBINE
+  free(list->reqs);
+#endif
+}
+
+#ifdef HAZARD
+// Traversal under hazard pointers (Michael): curr is only dereferenced
+// after it has been protected and found still linked from the protected,
+// unmarked pred; marked nodes are unlinked, never traversed
+void pos(long key, list_t *list)
+{
+  node_t *pred, *succ, *curr, *next;
+
+retry:
+#ifdef TEXTBOOK
+  pred = list->head;
+#else
+  pred = list->pred; // protected by HPCURSOR
+  if (ismarked(LOAD(&pred->next)) || key <= KEY(pred))
+    pred = list->head;
+#endif
+  PROTECT(HPPRED, pred);
+  curr = LOAD(&pred->next);
+  if (ismarked(curr)) {
+    INC(list->rtry);
+    goto retry;
+  }
+  INC(list->trav);
+  assert(KEY(pred) < key);
+
+  do {
+    PROTECT(HPCURR, curr);
+    next = LOAD(&pred->next);
+    if (next != curr) {
+      if (ismarked(next)) {
+        INC(list->rtry);
+        goto retry;
+      }
+      curr = next;
+      continue;
+    }
+
+    succ = LOAD(&curr->next);
+    if (ismarked(succ)) {
+      succ = getpointer(succ);
+      if (CAS(&pred->next, &curr, succ)) {
+        retire(curr, list);
+        curr = succ;
+      } else {
+        INC(list->fail);
+        BACKOFFCAS(list);
+#ifdef TEXTBOOK
+        INC(list->rtry);
+        goto retry;
+#else
+        if (ismarked(curr)) {
+          INC(list->rtry);
+          goto retry;
+        }
+#endif
+      }
+      INC(list->trav);
+      continue;
+    }
+
+    if (key <= KEY(curr)) {
+      assert(KEY(pred) < KEY(curr));
+      list->pred = pred;
+      list->curr = curr;
+      PROTECT(HPCURSOR, pred);
+      return;
+    }
+    pred = curr;
+    PROTECT(HPPRED, pred);
+    curr = succ;
+    INC(list->trav);
+  } while (1);
+}
+#else
+void pos(long key, list_t *list)
+{
+  node_t *pred, *succ, *curr, *next;
+
+#ifdef DOUBLY
+#ifdef CURSOR
+  pred = list->pred;
+#else
+  pred = list->pred;
+  if (key <= KEY(pred))
+    pred = list->head;
+#endif
+
+retry:
+  while (ismarked(LOAD(&pred->next)) || key <= KEY(pred)) {
+    INC(list->trav);
+    pred = LOAD(&pred->prev);
+  }
+  curr = getpointer(LOAD(&pred->next));
+  INC(list->trav);
+#else // DOUBLY
+retry:
+#if defined(SKIP)
+  pred = descend(key, NULL, 0, list);
+  if (ismarked(LOAD(&pred->next)))
+    pred = list->head;
+#elif defined(FINGERS)
+  pred = finger(key, list);
+#elif defined(TEXTBOOK)
+  pred = list->head;
+#else
+  pred = list->pred;
+  if (ismarked(LOAD(&pred->next)) || key <= KEY(pred))
+    pred = list->head;
+#endif
+
+  curr = getpointer(LOAD(&pred->next));
+  INC(list->trav);
+#endif // DOUBLY
+  assert(KEY(pred) < key);
+
+  do {
+    succ = LOAD(&curr->next);
+    while (ismarked(succ)) {
+      succ = getpointer(succ);
+      if (!CAS(&pred->next, &curr, succ)) {
+        INC(list->fail);
+        BACKOFFCAS(list);
+#ifdef TEXTBOOK
+        INC(list->rtry);
+        goto retry;
+#else
+        next = LOAD(&pred->next);
+        if (ismarked(next)) {
+          INC(list->rtry);
+          goto retry;
+        }
+        succ = next;
+#endif
+      }
+#ifdef EPOCH
+      else
+        retire(curr, list);
+#endif
+#ifdef DOUBLY
+      else
+        STORE(&succ->prev, pred);
+#endif
+
+      curr = getpointer(succ);
+      succ = LOAD(&succ->next);
+      INC(list->trav);
+    }
+#ifdef DOUBLY
+    if (LOAD(&curr->prev) != pred)
+      STORE(&curr->prev, pred);
+#endif
+
+    if (key <= KEY(curr)) {
+      assert(KEY(pred) < KEY(curr));
+      list->pred = pred;
+      list->curr = curr;
+#ifdef FINGERS
+      remember(pred, list);
+#endif
+      return;
+    }
+    pred = curr;
+    curr = getpointer(LOAD(&curr->next));
+    INC(list->trav);
+  } while (1);
+}
+#endif // HAZARD
+
+#ifdef MAP
+// Inserts key with value if absent; otherwise returns the present value in
+// old, after replacing it by value if swap
+static int insert(long key, long value, int swap, long *old, list_t *list)
+#else
+int add(long key, list_t *list)
+#endif
+{
+  node_t *pred, *curr, *node;
+#ifdef MAP
+  long v;
+#endif
+
+  node = NULL; // allocated once the key is known to be absent
+
+  ENTER(list);
+  BACKOFFSTART(list);
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  do {
+    pos(key, list);
+    pred = list->pred;
+    curr = list->curr;
+    if (KEY(curr) == key) {
+#ifdef MAP
+      v = LOAD(&curr->value);
+      while (v != TOMBSTONE && swap && !CAS(&curr->value, &v, value)) {
+        INC(list->fail);
+        BACKOFFCAS(list);
+      }
+      if (v == TOMBSTONE) {
+        mark(curr); // being removed, help
+        INC(list->rtry);
+        continue;
+      }
+      *old = v;
+      if (swap)
+        INC(list->upds);
+#endif
+      LEAVE(list);
+      if (node != NULL)
+        NODEFREE(node, list);
+      return 0; // already there
+    }
+
+    if (node == NULL) {
+      node = (node_t*)slaballoc(&list->slab);
+#ifdef LAYOUT_SPLIT
+      node->key = (long*)slaballoc(&list->keys);
+#endif
+      KEY(node) = key;
+#ifdef MAP
+      node->value = value;
+#endif
+    }
+
+    node->next = curr;
+#ifdef DOUBLY
+    node->prev = pred;
+#endif
+
+    if (CAS(&pred->next, &curr, node)) {
+#ifndef SPLITORDER // counted by the hash set, which also adds sentinels
+      INC(list->adds);
+      ADDED(list, 1);
+#endif
+#ifdef DOUBLY
+      STORE(&curr->prev, node);
+#endif
+#ifdef SKIP
+      int h = height(list);
+      if (h > 0)
+        build(node, h, list);
+#endif
+
+      LEAVE(list);
+      return 1;
+    }
+    INC(list->fail);
+    BACKOFFCAS(list);
+  } while (1);
+}
+
+int rem(long key, list_t *list)
+{
+  node_t *pred, *succ, *node;
+#ifdef MAP
+  long v;
+#else
+  node_t *markedsucc;
+#endif
+
+  ENTER(list);
+  BACKOFFSTART(list);
+  do {
+    pos(key, list);
+    pred = list->pred;
+    node = list->curr;
+    if (KEY(node) != key) {
+      LEAVE(list);
+      return 0; // not there
+    }
+
+#if defined(MAP)
+    v = LOAD(&node->value);
+    do {
+      if (v == TOMBSTONE) {
+        LEAVE(list);
+        return 0; // being removed
+      }
+      if (CAS(&node->value, &v, TOMBSTONE))
+        break;
+      INC(list->fail);
+      BACKOFFCAS(list);
+    } while (1);
+    mark(node);
+    succ = getpointer(LOAD(&node->next));
+#elif defined(TEXTBOOK)
+    succ = getpointer(LOAD(&node->next)); // unmarked
+    markedsucc = setmark(succ);
+
+    if (!CAS(&node->next, &succ, markedsucc)) {
+      INC(list->fail);
+      BACKOFFCAS(list);
+      continue;
+    }
+#else
+#ifdef FETCH
+    // x86 supports atomic-or, but not atomic-fetch-or, i.e., we cannot get the old value.
+    // If we do not use the return value of the fetch-or, the compiler is smart enough to
+    // use an atomic-or. If we use the return value, the atomic-fetch-or is emulated via
+    // a CAS loop.
+    // In this case it would be sufficient to use a pure atomic-or, although it has the
+    // drawback that we cannot tell WHO has set the bit, so we would also have to adapt
+    // the management of the free-list.
+
+    succ = (node_t*)FAO((_Atomic uint64_t*)&node->next, MARK_BIT);
+    if (ismarked(succ)) {
+      LEAVE(list);
+      return 0;
+    }
+#else    
+    succ = LOAD(&node->next);
+    do {
+      if (ismarked(succ)) {
+        LEAVE(list);
+        return 0;
+      }
+      markedsucc = setmark(succ);
+      if (CAS(&node->next, &succ, markedsucc))
+        break;
+      INC(list->fail);
+      BACKOFFCAS(list);
+    } while (1);
+#endif
+#endif
+    
+#if defined(EPOCH) || defined(HAZARD)
+    // the node is retired by whoever unlinks it
+    if (CAS(&pred->next, &node, succ))
+      retire(node, list);
+#else
+    if (!CAS(&pred->next, &node, succ))
+      node = list->curr; // beware!
+#endif
+#ifdef DOUBLY
+    STORE(&succ->prev, pred);
+#endif
+
+    INC(list->rems);
+    REMOVED(list, 1);
+
+    LEAVE(list);
+    return 1;
+  } while (1);
+}
+
+#ifndef HAZARD
+// where lookups start the read-only traversal for key
+static node_t *start(long key, list_t *list)
+{
+  node_t *curr;
+
+#ifdef DOUBLY
+#ifdef CURSOR
+  curr = list->pred;
+#else
+  curr = list->head;
+#endif
+  INC(list->cons);
+  // as in pos, never from a removed node: it may not lead to the key
+  while (key < KEY(curr) || ismarked(LOAD(&curr->next))) {
+    curr = LOAD(&curr->prev);
+    INC(list->cons);
+  }
+#else // DOUBLY
+#if defined(SKIP)
+  curr = descend(key, NULL, 0, list);
+#elif defined(FINGERS)
+  curr = finger(key, list);
+#elif defined(CURSOR)
+  curr = list->pred;
+  if (key < KEY(curr) || ismarked(LOAD(&curr->next)))
+    curr = list->head;
+#else
+  curr = list->head;
+#endif
+#endif // DOUBLY
+  assert(KEY(curr) <= key);
+
+  return curr;
+}
+#endif
+
+#ifdef MAP
+int get(long key, long *value, list_t *list)
+#else
+int con(long key, list_t *list)
+#endif
+{
+  node_t *curr;
+  int found;
+#ifdef MAP
+  long v;
+#endif
+
+#ifdef HAZARD
+  // marked nodes cannot be traversed safely, so lookups unlink as pos does
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  pos(key, list);
+  curr = list->curr;
+  INC(list->cons);
+#ifdef MAP
+  v = LOAD(&curr->value);
+  found = (KEY(curr) == key && v != TOMBSTONE);
+  if (found)
+    *value = v;
+#else
+  found = (KEY(curr) == key);
+#endif
+  LEAVE(list);
+
+  return found;
+#else
+  ENTER(list);
+  curr = start(key, list);
+
+  while (key > KEY(curr)) {
+    curr = getpointer(LOAD(&curr->next));
+    INC(list->cons);
+  }
+
+#if defined(FINGERS)
+  remember(curr, list);
+#elif defined(CURSOR)
+  list->pred = curr;
+#endif
+
+#ifdef MAP
+  // the tombstone precedes the mark
+  v = LOAD(&curr->value);
+  found = (KEY(curr) == key && v != TOMBSTONE);
+  if (found)
+    *value = v;
+#else
+  found = (KEY(curr) == key && !ismarked(LOAD(&curr->next)));
+#endif
+  LEAVE(list);
+
+  return found;
+#endif // HAZARD
+}
+
+#ifdef MAP
+// Replaces the value of key if present, and equal to expected unless any
+static int change(long key, long value, long expected, int any, long *old,
+                  list_t *list)
+{
+  node_t *curr;
+  long v;
+
+  ENTER(list);
+  BACKOFFSTART(list);
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  pos(key, list);
+  curr = list->curr;
+  if (KEY(curr) != key) {
+    LEAVE(list);
+    return 0; // not there
+  }
+
+  v = LOAD(&curr->value);
+  do {
+    if (v == TOMBSTONE || (!any && v != expected)) {
+      LEAVE(list);
+      *old = v;
+      return 0; // removed, or another value
+    }
+    if (CAS(&curr->value, &v, value))
+      break;
+    INC(list->fail);
+    BACKOFFCAS(list);
+  } while (1);
+  INC(list->upds);
+  LEAVE(list);
+
+  *old = v;
+  return 1;
+}
+
+int add(long key, list_t *list)
+{
+  long old;
+
+  return insert(key, 0, 0, &old, list);
+}
+
+int con(long key, list_t *list)
+{
+  long value;
+
+  return get(key, &value, list);
+}
+
+int put(long key, long value, long *old, list_t *list)
+{
+  assert(value != TOMBSTONE);
+  return !insert(key, value, 1, old, list);
+}
+
+int putifabsent(long key, long value, long *old, list_t *list)
+{
+  assert(value != TOMBSTONE);
+  return insert(key, value, 0, old, list);
+}
+
+int replace(long key, long value, long *old, list_t *list)
+{
+  assert(value != TOMBSTONE);
+  return change(key, value, 0, 1, old, list);
+}
+
+int update(long key, long expected, long value, list_t *list)
+{
+  long old;
+
+  assert(value != TOMBSTONE);
+  return change(key, value, expected, 0, &old, list);
+}
+#endif // MAP
+
+#ifndef SPLITORDER
+static node_t *newnode(long key, list_t *list)
+{
+  node_t *node;
+
+  node = (node_t*)slaballoc(&list->slab);
+#ifdef LAYOUT_SPLIT
+  node->key = (long*)slaballoc(&list->keys);
+#endif
+  KEY(node) = key;
+#ifdef MAP
+  node->value = 0;
+#endif
+
+  return node;
+}
+
+static void chain(node_t **nodes, int i, int n, list_t *list)
+{
+  nodes[i]->next = (i+1 < n) ? nodes[i+1] : list->tail;
+#ifdef DOUBLY
+  nodes[i]->prev = (i > 0) ? nodes[i-1] : list->head;
+#endif
+}
+
+// the sentinels and the index of the loaded nodes
+static void finish(node_t **nodes, int n, list_t *list)
+{
+  ADDED(list, n);
+  list->head->next = (n > 0) ? nodes[0] : list->tail;
+#if !defined(LAYOUT_DENSE) || defined(DOUBLY)
+  list->tail->prev = (n > 0) ? nodes[n-1] : list->head;
+#endif
+
+#ifdef SKIP
+  // each level linked in order, no searching
+  skip_t *skip;
+  index_t *last[MAXLEVEL], *idx;
+  int i, h, l, level;
+
+  skip = (skip_t*)list->head->aux;
+  for (l = 0; l < MAXLEVEL; l++)
+    last[l] = &skip->heads[l];
+  level = 1;
+  for (i = 0; i < n; i++) {
+    h = height(list);
+    for (l = 0; l < h; l++) {
+      idx = (index_t*)slaballoc(&list->index);
+      idx->node = nodes[i];
+      idx->down = (l > 0) ? last[l-1] : NULL;
+      idx->right = NULL;
+      last[l]->right = idx;
+      last[l] = idx;
+    }
+    if (h > level)
+      level = h;
+  }
+  skip->level = level;
+#endif
+}
+
+// Links the sorted, distinct keys into the empty list, at quiescence. With
+// team, all threads of the enclosing parallel region call load() for the
+// same list and share the work; each thread allocates the nodes it links.
+void load(long keys[], int n, int team, list_t *list)
+{
+  node_t **nodes;
+  int i;
+
+  if (!team) {
+    nodes = (node_t**)malloc(n*sizeof(node_t*));
+    assert(n == 0 || nodes != NULL);
+    for (i = 0; i < n; i++)
+      nodes[i] = newnode(keys[i], list);
+    for (i = 0; i < n; i++)
+      chain(nodes, i, n, list);
+    finish(nodes, n, list);
+    free(nodes);
+    return;
+  }
+
+#pragma omp single copyprivate(nodes)
+  {
+    nodes = (node_t**)malloc(n*sizeof(node_t*));
+    assert(n == 0 || nodes != NULL);
+  }
+#pragma omp for schedule(static)
+  for (i = 0; i < n; i++)
+    nodes[i] = newnode(keys[i], list);
+#pragma omp for schedule(static)
+  for (i = 0; i < n; i++)
+    chain(nodes, i, n, list);
+#pragma omp single
+  {
+    finish(nodes, n, list);
+    free(nodes);
+  }
+}
+
+// curr, found by a lookup for key, holds key and is not removed
+static inline int present(node_t *curr, long key)
+{
+#ifdef MAP
+  return (KEY(curr) == key && LOAD(&curr->value) != TOMBSTONE);
+#else
+  return (KEY(curr) == key && !ismarked(LOAD(&curr->next)));
+#endif
+}
+
+// Batches of sorted keys in one forward pass: each key is positioned from
+// the pred of the previous one, and the run of absent keys between pred
+// and curr is linked with one CAS. res[i] is the result for keys[i].
+void add_batch(long keys[], int n, int res[], list_t *list)
+{
+  node_t *pred, *curr, *first, *last, *node;
+  int i, j, added;
+
+  ENTER(list);
+  BACKOFFSTART(list);
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  i = 0;
+  while (i < n) {
+    if (i > 0 && keys[i] == keys[i-1]) {
+      res[i++] = 0; // twice in the batch
+      continue;
+    }
+    pos(keys[i], list);
+    pred = list->pred;
+    curr = list->curr;
+    if (KEY(curr) == keys[i]) {
+#ifdef MAP
+      if (LOAD(&curr->value) == TOMBSTONE) {
+        mark(curr); // being removed, help
+        INC(list->rtry);
+        continue;
+      }
+#endif
+      res[i++] = 0; // already there
+      continue;
+    }
+
+    first = last = newnode(keys[i], list);
+#ifdef SKIP
+    first->free = NULL; // the run, for the index
+#endif
+    res[i] = 1;
+    added = 1;
+    for (j = i+1; j < n && keys[j] < KEY(curr); j++) {
+      if (keys[j] == keys[j-1]) {
+        res[j] = 0;
+        continue;
+      }
+      node = newnode(keys[j], list);
+#ifdef DOUBLY
+      node->prev = last;
+#endif
+#ifdef SKIP
+      node->free = last;
+#endif
+      last->next = node;
+      last = node;
+      res[j] = 1;
+      added++;
+    }
+    last->next = curr;
+#ifdef DOUBLY
+    first->prev = pred;
+#endif
+
+    if (CAS(&pred->next, &curr, first)) {
+#ifdef DOUBLY
+      STORE(&curr->prev, last);
+#endif
+      list->adds += added;
+      ADDED(list, added);
+#ifdef SKIP
+      int h;
+      for (node = last; node != NULL; node = node->free) {
+        h = height(list);
+        if (h > 0)
+          build(node, h, list);
+      }
+#endif
+#ifndef HAZARD
+      list->pred = last; // the next key is larger (HAZARD: not protected)
+#endif
+      i = j;
+    } else {
+      INC(list->fail);
+      BACKOFFCAS(list);
+      do {
+        node = first;
+        first = node->next;
+        NODEFREE(node, list);
+      } while (node != last);
+    }
+  }
+  LEAVE(list);
+}
+
+void rem_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  for (i = 0; i < n; i++)
+    res[i] = rem(keys[i], list); // rem() starts from the pred of the previous key
+}
+
+void con_batch(long keys[], int n, int res[], list_t *list)
+{
+  node_t *curr;
+  int i;
+
+#ifdef HAZARD
+  ENTER(list);
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  for (i = 0; i < n; i++) {
+    pos(keys[i], list);
+    curr = list->curr;
+    INC(list->cons);
+    res[i] = present(curr, keys[i]);
+  }
+  LEAVE(list);
+#else
+  if (n == 0)
+    return;
+
+  ENTER(list);
+  curr = start(keys[0], list);
+  for (i = 0; i < n; i++) {
+#ifdef SKIP
+    node_t *node = descend(keys[i], NULL, 0, list);
+    if (KEY(node) > KEY(curr))
+      curr = node;
+#endif
+    while (keys[i] > KEY(curr)) {
+      curr = getpointer(LOAD(&curr->next));
+      INC(list->cons);
+    }
+    res[i] = present(curr, keys[i]);
+  }
+#if defined(FINGERS)
+  remember(curr, list);
+#elif defined(CURSOR)
+  list->pred = curr;
+#endif
+  LEAVE(list);
+#endif // HAZARD
+}
+#endif // SPLITORDER
+
+#ifndef SPLITORDER
+void range(long lo, long hi, iter_t *iter, list_t *list)
+{
+  if (lo == LONG_MIN)
+    lo++; // the head
+
+  ENTER(list);
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  pos(lo, list);
+  iter->list = list;
+  iter->curr = list->curr;
+  iter->lo = lo;
+  iter->hi = hi;
+}
+
+int rangenext(iter_t *iter, long *key)
+{
+  list_t *list;
+  node_t *curr;
+
+  list = iter->list;
+#ifdef HAZARD
+  // only nodes found by pos() are protected, every step starts from the cursor
+  while (iter->lo <= iter->hi) {
+    pos(iter->lo, list);
+    curr = list->curr;
+    if (curr == list->tail || KEY(curr) > iter->hi)
+      break;
+    if (KEY(curr) < iter->hi) {
+      iter->lo = KEY(curr)+1;
+    } else { // the last key of the range, no key+1 at LONG_MAX
+      iter->lo = LONG_MAX;
+      iter->hi = LONG_MIN;
+    }
+#ifdef MAP
+    if (LOAD(&curr->value) == TOMBSTONE)
+      continue;
+#endif
+    *key = KEY(curr);
+    return 1;
+  }
+  iter->lo = LONG_MAX; // done: lo > hi without hi+1
+  iter->hi = LONG_MIN;
+
+  return 0;
+#else
+  node_t *succ;
+
+  curr = iter->curr;
+  while (curr != list->tail && KEY(curr) <= iter->hi) {
+    succ = LOAD(&curr->next);
+    INC(list->trav);
+#ifdef MAP
+    if (!ismarked(succ) && LOAD(&curr->value) != TOMBSTONE) {
+#else
+    if (!ismarked(succ)) {
+#endif
+      *key = KEY(curr);
+      iter->curr = succ;
+      return 1;
+    }
+    curr = getpointer(succ);
+  }
+  iter->curr = curr;
+
+  return 0;
+#endif // HAZARD
+}
+
+void rangedone(iter_t *iter)
+{
+  LEAVE(iter->list);
+}
+#endif // SPLITORDER
+
+#ifdef SPLITORDER
+#undef add
+#undef rem
+#undef con
+
+// Split-ordered hash set (Shalev and Shavit): all keys are in the one list,
+// sorted by their bit-reversed value, so that the keys of bucket b follow
+// the sentinel of b and precede those of the buckets split off from b when
+// the table doubles. Sentinels are inserted lazily after the sentinel of the
+// parent bucket (b without its highest bit), the head being that of bucket 0,
+// and are never removed. Doubling the table is a CAS on its size.
+// Keys must be in [0,LONG_MAX).
+
+#define SIGNBIT (1UL<<63)
+
+static inline unsigned long reverse(unsigned long x)
+{
+  x = ((x>>1)&0x5555555555555555UL)|((x&0x5555555555555555UL)<<1);
+  x = ((x>>2)&0x3333333333333333UL)|((x&0x3333333333333333UL)<<2);
+  x = ((x>>4)&0x0F0F0F0F0F0F0F0FUL)|((x&0x0F0F0F0F0F0F0F0FUL)<<4);
+  return __builtin_bswap64(x);
+}
+
+// split-order keys as list keys; the sentinel of bucket 0 is LONG_MIN
+#define REGULAR(_k)  ((long)((reverse(_k)|1)^SIGNBIT))
+#define SENTINEL(_b) ((long)(reverse(_b)^SIGNBIT))
+
+static _Atomic(node_t*) *bucketslot(unsigned long b, hash_t *hash)
+{
+  _Atomic(node_t*) *segment, *new;
+  int s;
+
+  s = (b < 2) ? 0 : 63-__builtin_clzl(b);
+  segment = LOAD(&hash->segment[s]);
+  if (segment == NULL) {
+    new = (_Atomic(node_t*)*)calloc((s == 0) ? 2 : 1UL<<s, sizeof(_Atomic(node_t*)));
+    assert(new != NULL);
+    while (segment == NULL) {
+      if (CAS(&hash->segment[s], &segment, new)) {
+        segment = new;
+        new = NULL;
+      }
+    }
+    free(new);
+  }
+
+  return &segment[(s == 0) ? b : b-(1UL<<s)];
+}
+
+// the sentinel of bucket b, inserted if needed
+static node_t *bucket(unsigned long b, list_t *list)
+{
+  _Atomic(node_t*) *slot;
+  node_t *sentinel, *parent, *expected;
+
+  slot = bucketslot(b, (hash_t*)list->head->aux);
+  sentinel = LOAD(slot);
+  if (sentinel != NULL)
+    return sentinel;
+
+  parent = bucket(b&~(1UL<<(63-__builtin_clzl(b))), list);
+  list->pred = parent;
+  listadd(SENTINEL(b), list);
+  list->pred = parent;
+  pos(SENTINEL(b), list); // the sentinel, whoever inserted it
+  sentinel = list->curr;
+  assert(KEY(sentinel) == SENTINEL(b));
+
+  expected = NULL;
+  while (!CAS(slot, &expected, sentinel) && expected == NULL);
+
+  return sentinel;
+}
+
+static void flush(long delta, unsigned long size, list_t *list)
+{
+  hash_t *hash;
+  long count;
+
+  hash = (hash_t*)list->head->aux;
+  count = atomic_fetch_add(&hash->count, delta)+delta;
+  list->delta = 0;
+  if (count > (long)(LOADFACTOR*size))
+    CAS(&hash->size, &size, 2*size); // if still that size
+}
+
+int add(long key, list_t *list)
+{
+  unsigned long size;
+  int ok;
+
+  assert(0 <= key && key < LONG_MAX);
+  size = LOAD(&((hash_t*)list->head->aux)->size);
+  list->pred = bucket(key&(size-1), list);
+  ok = listadd(REGULAR(key), list);
+  if (ok) {
+    INC(list->adds);
+    ADDED(list, 1);
+    if (++list->delta >= FLUSH)
+      flush(list->delta, size, list);
+  }
+
+  return ok;
+}
+
+int rem(long key, list_t *list)
+{
+  unsigned long size;
+  int ok;
+
+  assert(0 <= key && key < LONG_MAX);
+  size = LOAD(&((hash_t*)list->head->aux)->size);
+  list->pred = bucket(key&(size-1), list);
+  ok = listrem(REGULAR(key), list);
+  if (ok && --list->delta <= -FLUSH)
+    flush(list->delta, size, list);
+
+  return ok;
+}
+
+int con(long key, list_t *list)
+{
+  unsigned long size;
+
+  assert(0 <= key && key < LONG_MAX);
+  size = LOAD(&((hash_t*)list->head->aux)->size);
+  list->pred = bucket(key&(size-1), list);
+
+  return listcon(REGULAR(key), list);
+}
+
+// in split order the keys are not sorted, but adding is O(1) expected
+void load(long keys[], int n, int team, list_t *list)
+{
+  int i;
+
+  if (team) {
+#pragma omp for schedule(static)
+    for (i = 0; i < n; i++)
+      add(keys[i], list);
+  } else {
+    for (i = 0; i < n; i++)
+      add(keys[i], list);
+  }
+}
+
+// the keys of a batch are scattered over the buckets
+void add_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = add(keys[i], list);
+}
+
+void rem_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = rem(keys[i], list);
+}
+
+void con_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = con(keys[i], list);
+}
+#endif // SPLITORDER
+
+#ifdef COMBINE
+#undef add
+#undef rem
+
+// Flat combining with elimination (Hendler et al.), switched on by each
+// thread whose add and rem fail too often: the operation is published in the
+// record of the thread, and whoever gets the combiner lock applies all
+// published operations, sorted by key, in one pass from its cursor. An add
+// and a rem of the same key eliminate each other without touching the list.
+// Published operations wait for the combiner, i.e., are blocking.
+
+#define IDLE 0
+#define ADD  1
+#define REM  2
+#define DONE 3
+
+#define WINDOW    64 // add and rem between switches
+#define CONTENDED 16 // fail+rtry per window to start combining
+#define SPINS     64 // before yielding the processor
+
+static int reqcmp(const void *a, const void *b)
+{
+  const req_t *x = (const req_t*)a;
+  const req_t *y = (const req_t*)b;
+
+  if (x->key != y->key)
+    return (x->key < y->key) ? -1 : 1;
+  return x->op-y->op; // adds before rems
+}
+
+// with the combiner lock held
+static void combine(list_t *list)
+{
+  comb_t *comb;
+  req_t *reqs;
+  int i, j, k, n, m, op, adds, records;
+
+  comb = (comb_t*)list->head->aux;
+  reqs = (req_t*)list->reqs;
+  records = atomic_load(&comb->records);
+  n = 0;
+  for (i = 0; i < records; i++) {
+    op = atomic_load_explicit(&comb->pub[i].state, memory_order_acquire);
+    if (op == ADD || op == REM) {
+      reqs[n].key = comb->pub[i].key;
+      reqs[n].op = op;
+      reqs[n].pub = i;
+      n++;
+    }
+  }
+  qsort(reqs, n, sizeof(req_t), reqcmp);
+
+  for (i = 0; i < n; i = j) {
+    adds = 0;
+    for (j = i; j < n && reqs[j].key == reqs[i].key; j++)
+      if (reqs[j].op == ADD)
+        adds++;
+    // m pairs of an add and a rem both succeed, linearized back to back as
+    // add and rem if the key is absent, else as rem and add
+    m = (adds < j-i-adds) ? adds : j-i-adds;
+    for (k = i; k < j; k++) {
+      if (k < i+m || (k >= i+adds && k < i+adds+m)) {
+        comb->pub[reqs[k].pub].res = 1;
+        if (reqs[k].op == ADD) {
+          INC(list->adds);
+          ADDED(list, 1);
+        } else {
+          INC(list->rems);
+          REMOVED(list, 1);
+        }
+        INC(list->elim);
+      } else if (reqs[k].op == ADD)
+        comb->pub[reqs[k].pub].res = directadd(reqs[k].key, list);
+      else
+        comb->pub[reqs[k].pub].res = directrem(reqs[k].key, list);
+      atomic_store_explicit(&comb->pub[reqs[k].pub].state, DONE, memory_order_release);
+    }
+  }
+}
+
+static int publish(long key, int op, list_t *list)
+{
+  comb_t *comb;
+  pub_t *pub;
+  int res, spins, own;
+
+  comb = (comb_t*)list->head->aux;
+  pub = &comb->pub[list->pub];
+  pub->key = key;
+  atomic_store_explicit(&pub->state, op, memory_order_release);
+  INC(list->pubs);
+
+  own = 0;
+  spins = 0;
+  while (atomic_load_explicit(&pub->state, memory_order_acquire) != DONE) {
+    if (atomic_load_explicit(&comb->lock, memory_order_relaxed) == 0 &&
+        atomic_exchange_explicit(&comb->lock, 1, memory_order_acquire) == 0) {
+      if (atomic_load_explicit(&pub->state, memory_order_acquire) != DONE) {
+        combine(list); // includes the own operation
+        own = 1;
+      }
+      atomic_store_explicit(&comb->lock, 0, memory_order_release);
+      break;
+    }
+    if (++spins == SPINS) {
+      spins = 0;
+      sched_yield();
+    }
+  }
+  if (!own)
+    INC(list->hits);
+
+  res = pub->res;
+  atomic_store_explicit(&pub->state, IDLE, memory_order_relaxed);
+
+  return res;
+}
+
+// at the end of a window: combining after too many failed CAS, direct
+// again when the combiner did not do most published operations for others
+static void adapt(list_t *list)
+{
+  if (++list->window < WINDOW)
+    return;
+  if (list->combining)
+    list->combining = (list->hits > list->whits+(list->pubs-list->wpubs)/2);
+  else
+    list->combining = (list->fail+list->rtry > list->wfail+CONTENDED);
+  list->window = 0;
+  list->wfail = list->fail+list->rtry;
+  list->wpubs = list->pubs;
+  list->whits = list->hits;
+}
+
+int add(long key, list_t *list)
+{
+  int res;
+
+  if (list->combining)
+    res = publish(key, ADD, list);
+  else
+    res = directadd(key, list);
+  adapt(list);
+
+  return res;
+}
+
+int rem(long key, list_t *list)
+{
+  int res;
+
+  if (list->combining)
+    res = publish(key, REM, list);
+  else
+    res = directrem(key, list);
+  adapt(list);
+
+  return res;
+}
+#endif // COMBINE
@@ -1,38 +1,281 @@
-/* (C) Jesper Larsson Traff, May 2020 */
-/* Improved lock-free linked list implementations */
-
-#define COUNTERS
-
-#ifdef COUNTERS
-#define INC(_c) ((_c)++)
-#else
-#define INC(_c)
-#endif
-
-typedef struct _node {
-  _Atomic(struct _node *) next;
-  _Atomic(struct _node *) prev;
-  struct _node *free; // for freelist
-  char padding[40]; // fill the cacheline
-  long key;
-} node_t;
-
-typedef struct _list {
-  node_t *head, *tail; // sentinels, possibly shared
-  
-  node_t *curr; // private cursor (last operation)
-  node_t *pred; // predecessor of cursor
-  
-  node_t *free; // private free list
-  
-#ifdef COUNTERS
-  unsigned long long adds, rems, cons, trav, fail, rtry;
-#endif
-} list_t;
-  
-void init(node_t *head, node_t *tail, list_t* list);
-void clean(list_t *list);
-
-int add(long key, list_t *list);
-int rem(long key, list_t *list);
-int con(long key, list_t *list);
+/* (C) Jesper Larsson Traff, May 2020 */
+/* Improved lock-free linked list implementations */
+
+#include "slab.h"
+#include "backoff.h"
+#include "stats.h"
+
+#define COUNTERS
+
+#ifdef COUNTERS
+#define INC(_c) ((_c)++)
+#else
+#define INC(_c)
+#endif
+
+// successful add and rem, also in the shard of the thread (stats.h)
+#define ADDED(_l,_n)   shardadd(&(_l)->shard->adds,_n)
+#define REMOVED(_l,_n) shardadd(&(_l)->shard->rems,_n)
+
+// Node layouts:
+// default        - 72 bytes, key on the second cache line (as in the paper)
+// LAYOUT_ALIGNED - 64 bytes, cache line aligned, key next to next
+// LAYOUT_DENSE   - unpadded: next and key (16 bytes), plus prev for DOUBLY
+//                  and free for EPOCH/HAZARD or aux for SKIP/SPLITORDER/COMBINE (24 bytes)
+// LAYOUT_SPLIT   - keys kept in a separate, dense per thread key array
+// UNROLLED       - up to BLOCK sorted keys per node, key is the largest
+// MAP adds a value after the key to all but the unrolled layout
+// SEQUENTIAL     - plain next, key and prev of linkedlistseq.c, no atomics
+#if defined(SEQUENTIAL)
+typedef struct _node {
+  struct _node *next;
+  long key;
+  struct _node *prev;
+} node_t;
+#elif defined(UNROLLED)
+#ifndef BLOCK
+#define BLOCK 8
+#endif
+typedef struct _node {
+  _Alignas(64) _Atomic(struct _node *) next;
+  long key;
+  _Atomic(struct _node *) prev;
+  int count;
+  long keys[BLOCK]; // sorted, padded with LONG_MAX
+} node_t;
+#elif defined(LAYOUT_ALIGNED)
+typedef struct _node {
+  _Alignas(64) _Atomic(struct _node *) next;
+  long key;
+#ifdef MAP
+  _Atomic long value;
+#endif
+  _Atomic(struct _node *) prev;
+  union {
+    struct _node *free; // for lists of retired nodes
+    void *aux;          // head sentinel: shared list state (index, table)
+  };
+} node_t;
+#elif defined(LAYOUT_DENSE)
+typedef struct _node {
+  _Atomic(struct _node *) next;
+  long key;
+#ifdef MAP
+  _Atomic long value;
+#endif
+#ifdef DOUBLY
+  _Atomic(struct _node *) prev;
+#endif
+#if defined(EPOCH) || defined(HAZARD) || defined(SKIP) || defined(SPLITORDER) || defined(COMBINE)
+  union {
+    struct _node *free; // for lists of retired nodes
+    void *aux;          // head sentinel: shared list state (index, table)
+  };
+#endif
+} node_t;
+#elif defined(LAYOUT_SPLIT)
+typedef struct _node {
+  _Atomic(struct _node *) next;
+  long *key; // into the key array of the allocating thread
+#ifdef MAP
+  _Atomic long value;
+#endif
+  _Atomic(struct _node *) prev;
+  union {
+    struct _node *free; // for lists of retired nodes
+    void *aux;          // head sentinel: shared list state (index, table)
+  };
+} node_t;
+#else
+typedef struct _node {
+  _Atomic(struct _node *) next;
+  _Atomic(struct _node *) prev;
+  union {
+    struct _node *free; // for lists of retired nodes
+    void *aux;          // head sentinel: shared list state (index, table)
+  };
+  char padding[40]; // fill the cacheline
+  long key;
+#ifdef MAP
+  _Atomic long value;
+#endif
+} node_t;
+#endif
+
+#ifdef LAYOUT_SPLIT
+#define KEY(_n) (*(_n)->key)
+#else
+#define KEY(_n) ((_n)->key)
+#endif
+
+#ifdef FINGERS
+#ifndef NFINGERS
+#define NFINGERS 4
+#endif
+#endif
+
+typedef struct _list {
+  node_t *head, *tail; // sentinels, possibly shared
+  
+  node_t *curr; // private cursor (last operation)
+  node_t *pred; // predecessor of cursor
+#ifdef FINGERS
+  node_t *fingers[NFINGERS]; // remembered positions (CURSOR), head if unused
+  unsigned long used[NFINGERS]; // operation that last started from the finger
+  unsigned long ops;         // operations so far
+  int finger;                // the one the operation started from, -1 for head
+  unsigned long long hops;   // trav+cons when the operation started
+  double density;            // keys per hop of the last long walk
+#endif
+  
+  slab_t slab; // private node allocation, released in bulk by clean()
+#ifdef LAYOUT_SPLIT
+  slab_t keys; // private key array
+#endif
+
+#ifdef SPLITORDER
+  long delta;          // key count changes not yet added to the table
+#endif
+#ifdef SKIP
+  slab_t index;        // private index node allocation
+  unsigned long seed;  // for the heights of index towers
+#endif
+
+#ifdef COMBINE
+  int pub;             // publication record of this thread
+  int combining;       // add and rem are published to the combiner
+  int window;          // add and rem in the current window
+  unsigned long long wfail, wpubs, whits; // at the start of the window
+  void *reqs;          // scratch space for combining
+#endif
+
+#ifdef EPOCH
+  // epoch-based reclamation: nodes retired in epoch limboepoch[i] are
+  // kept in limbo[i] until no thread can still be traversing them
+  node_t *limbo[3];
+  unsigned long limboepoch[3];
+  unsigned long epoch; // epoch of the last operation (cursor validity)
+  int retired;         // retirements since last attempt to advance
+  int slot;            // announcement slot of this thread
+#endif
+#ifdef HAZARD
+  // hazard pointers: retired nodes are kept in limbo while protected
+  node_t *limbo;
+  node_t **hazards;    // scratch space for scanning
+  int retired;         // length of limbo
+  int slot;            // hazard pointer slot of this thread
+#endif
+  
+#ifdef COUNTERS
+  unsigned long long adds, rems, cons, trav, fail, rtry;
+  unsigned long long upds; // value updates (MAP)
+  unsigned long long pubs, hits, elim; // published, done by another combiner, eliminated (COMBINE)
+#endif
+
+  backoff_t backoff; // contention management after failed CAS
+  shard_t *shard;    // own, or the one of the thread in a stats_t
+  shard_t own;
+} list_t;
+  
+void create(node_t *head, node_t *tail);  // the shared sentinels, once per list
+void destroy(node_t *head, node_t *tail); // at quiescence, after clean() by all threads
+void init(node_t *head, node_t *tail, list_t* list); // per thread
+void clean(list_t *list); // at quiescence: releases all nodes allocated by list
+
+// per thread after init(): its adds and rems from then on are counted in
+// stats, for size() and statistics that any thread can read
+static inline void attach(stats_t *stats, list_t *list)
+{
+  list->shard = statsattach(stats);
+}
+
+int add(long key, list_t *list);
+int rem(long key, list_t *list);
+int con(long key, list_t *list);
+
+// Bulk load of sorted, distinct keys into the empty list, at quiescence;
+// with team, called by all threads of a parallel region, which share the work
+void load(long keys[], int n, int team, list_t *list);
+
+// sorted batches of keys in one pass, res[i] the result for keys[i]
+void add_batch(long keys[], int n, int res[], list_t *list);
+void rem_batch(long keys[], int n, int res[], list_t *list);
+void con_batch(long keys[], int n, int res[], list_t *list);
+
+#ifdef POLICY
+// The variants of lockfreelist.hpp on the default node layout, selected at
+// run time (policylist.cpp); all operations above go to the selected one
+extern const char *policies[]; // names, NULL terminated
+int policy(const char *name);  // selects the variant, 0 if unknown
+const char *policyname(void);
+
+// String keys, NUL terminated and not copied (valid while in the list), on
+// the selected variant: STR_PLAIN compares with strcmp, STR_PREFIX keeps the
+// first 8 bytes inline. For the lists init()ed after strkeys(), instead of
+// add(), rem() and con().
+#define STR_NONE   0
+#define STR_PLAIN  1
+#define STR_PREFIX 2
+
+void strkeys(int style);
+int addstr(const char *key, list_t *list);
+int remstr(const char *key, list_t *list);
+int constr(const char *key, list_t *list);
+#endif
+
+#ifndef SPLITORDER
+// Range iteration over the keys in [lo,hi] in ascending order, skipping
+// removed keys. Keys present from range() to rangedone() are all seen.
+// The iteration is one operation of the thread: no other operations on
+// the list by the same thread before rangedone().
+typedef struct _iter {
+  list_t *list;
+  node_t *curr; // where to continue
+  long lo, hi;  // keys not yet visited
+#ifdef UNROLLED
+  int i;        // next key in curr
+#endif
+} iter_t;
+
+void range(long lo, long hi, iter_t *iter, list_t *list);
+int rangenext(iter_t *iter, long *key); // 1 and the next key, 0 at the end
+void rangedone(iter_t *iter);
+
+static inline long rangecount(long lo, long hi, list_t *list)
+{
+  iter_t iter;
+  long key, n;
+
+  n = 0;
+  range(lo, hi, &iter, list);
+  while (rangenext(&iter, &key))
+    n++;
+  rangedone(&iter);
+
+  return n;
+}
+
+static inline long rangesum(long lo, long hi, list_t *list)
+{
+  iter_t iter;
+  long key, sum;
+
+  sum = 0;
+  range(lo, hi, &iter, list);
+  while (rangenext(&iter, &key))
+    sum += key;
+  rangedone(&iter);
+
+  return sum;
+}
+#endif
+
+#ifdef MAP
+// Map flavor, a value per key; values must not be LONG_MIN. add() inserts
+// the value 0. All operations take one traversal.
+int get(long key, long *value, list_t *list); // 1 and value if present
+int put(long key, long value, long *old, list_t *list); // insert or replace: 1 and old value if replaced
+int putifabsent(long key, long value, long *old, list_t *list); // 1 if inserted, else 0 and present value
+int replace(long key, long value, long *old, list_t *list); // 1 and old value if present
+int update(long key, long expected, long value, list_t *list); // 1 if present with value expected
+#endif
@@ -1,171 +1,319 @@
-/* (C) Jesper Larsson Traff, May 2020 */
-/* Improved lock-free linked list implementations */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <limits.h>
-
-#include <assert.h>
-
-#include "linkedlist.h"
-
-//#define DOUBLY
-//#define CURSOR / only with DOUBLY
-
-#ifdef COUNTERS
-#define INC(_c) ((_c)++)
-#else
-#define INC(_c)
-#endif
-
-void init(node_t *head, node_t *tail, list_t *list)
-{
-  list->head = head;
-  list->tail = tail;
-  
-  // the sentinels
-  list->head->key = LONG_MIN;
-  list->head->next = tail;
-  list->head->prev = NULL;
-
-  list->tail->key = LONG_MAX;
-  list->tail->next = NULL;
-  list->tail->prev = head;
-
-  list->pred = head;
-  list->curr = NULL;
-  
-  list->free = NULL;
-
-#ifdef COUNTERS
-  list->adds = 0;
-  list->rems = 0;
-  list->cons = 0;
-  list->trav = 0;
-  list->fail = 0;
-  list->rtry = 0;
-#endif
-}
-
-void clean(list_t *list)
-{
-  node_t *next, *node;
-
-  next = list->free;
-  while (next!=NULL) {
-    node = next; next = next->free;
-    free(node);
-  }
-  list->free = NULL;
-}
-
-void pos(long key, list_t *list)
-{
-  node_t *pred, *curr;
-
-#ifdef DOUBLY
-#ifdef CURSOR
-  curr = list->pred;
-#else
-  curr = list->head;
-#endif
-  if (curr->key>=key) {
-    pred = curr->prev;
-    while (key<pred->key) {
-      curr = pred; pred = pred->prev;
-      INC(list->trav);
-    }
-  } else
-#else
-  curr = list->head;
-#endif
-    {
-      do {
-	pred = curr; curr = curr->next;
-	INC(list->trav);
-      } while (key>curr->key);
-    }
-  
-  list->pred = pred;
-  list->curr = curr;
-  assert(pred->key<curr->key);
-}
-
-int add(long key, list_t *list)
-{
-  node_t *pred, *curr, *node;
-
-  pos(key,list);
-  pred = list->pred; curr = list->curr;
-  if (curr->key==key) return 0; // already there
-  
-  INC(list->adds);
-  
-  node = (node_t*)malloc(sizeof(node_t));
-  assert(node!=NULL);
-  
-  node->key = key;
-  node->next = curr;
-  pred->next = node;
-  
-#ifdef DOUBLY
-  node->prev = pred;
-  curr->prev = node;
-#endif
-  
-  return 1;
-}
-
-int rem(long key, list_t *list)
-{
-  node_t *pred, *node;
-
-  pos(key,list);
-  pred = list->pred;
-  node = list->curr;
-  if (node->key!=key) return 0; // not there
-  
-  INC(list->rems);
-  
-  pred->next = node->next;
-#ifdef DOUBLY
-  node->next->prev = pred;
-#endif
-  
-  node->free = list->free;
-  list->free = node;
-  
-  return 1;
-}
- 
-int con(long key, list_t *list)
-{
-  node_t *curr;
-
-#ifdef DOUBLY
-#ifdef CURSOR
-  curr = list->pred;
-#else
-  curr = list->head;
-#endif
-  INC(list->cons);
-  while (key<curr->key) {
-    curr = curr->prev;
-    INC(list->cons);
-  }
-#else
-  curr = list->head;
-#endif
-  while (key>curr->key) {
-    curr = curr->next;
-    INC(list->cons);
-  }
-
-#ifdef DOUBLY
-#ifdef CURSOR
-  list->pred = curr;
-#endif
-#endif
-  
-  return (curr->key==key);
-}
+/* (C) Jesper Larsson Traff, May 2020 */
+/* Improved lock-free linked list implementations */
+/* The sequential list: the baseline of listbench in every executable and,
+   with SEQUENTIAL, the list of the lsequential executables */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <assert.h>
+
+#include "linkedlist.h"
+#include "linkedlistseq.h"
+
+//#define DOUBLY
+//#define CURSOR
+
+#ifdef COUNTERS
+#define INC(_c) ((_c)++)
+#else
+#define INC(_c)
+#endif
+
+void seqcreate(seqnode_t *head, seqnode_t *tail)
+{
+  // the sentinels
+  head->key = LONG_MIN;
+  head->next = tail;
+  head->prev = NULL;
+
+  tail->key = LONG_MAX;
+  tail->next = NULL;
+  tail->prev = head;
+}
+
+void seqinit(seqnode_t *head, seqnode_t *tail, seqlist_t *list)
+{
+  list->head = head;
+  list->tail = tail;
+
+  list->pred = head;
+  list->curr = NULL;
+  
+  slabinit(&list->slab,sizeof(seqnode_t));
+
+  list->adds = 0;
+  list->rems = 0;
+  list->cons = 0;
+  list->trav = 0;
+}
+
+void seqclean(seqlist_t *list)
+{
+  slabrelease(&list->slab);
+}
+
+static void seqpos(long key, seqlist_t *list)
+{
+  seqnode_t *pred, *curr;
+
+#ifdef CURSOR
+  curr = list->pred;
+#else
+  curr = list->head;
+#endif
+#ifdef DOUBLY
+  if (curr->key>=key) {
+    pred = curr->prev;
+    while (key<=pred->key) {
+      curr = pred; pred = pred->prev;
+      INC(list->trav);
+    }
+  } else
+#else
+  if (curr->key>=key) curr = list->head; // behind the cursor
+#endif
+    {
+      do {
+	pred = curr; curr = curr->next;
+	INC(list->trav);
+      } while (key>curr->key);
+    }
+  
+  list->pred = pred;
+  list->curr = curr;
+  assert(pred->key<curr->key);
+}
+
+int seqadd(long key, seqlist_t *list)
+{
+  seqnode_t *pred, *curr, *node;
+
+  seqpos(key,list);
+  pred = list->pred; curr = list->curr;
+  if (curr->key==key) return 0; // already there
+  
+  INC(list->adds);
+  
+  node = (seqnode_t*)slaballoc(&list->slab);
+  
+  node->key = key;
+  node->next = curr;
+  pred->next = node;
+  
+#ifdef DOUBLY
+  node->prev = pred;
+  curr->prev = node;
+#endif
+  
+  return 1;
+}
+
+int seqrem(long key, seqlist_t *list)
+{
+  seqnode_t *pred, *node;
+
+  seqpos(key,list);
+  pred = list->pred;
+  node = list->curr;
+  if (node->key!=key) return 0; // not there
+  
+  INC(list->rems);
+  
+  pred->next = node->next;
+#ifdef DOUBLY
+  node->next->prev = pred;
+#endif
+  
+  slabfree(node,&list->slab); // nobody else can see it
+  
+  return 1;
+}
+ 
+int seqcon(long key, seqlist_t *list)
+{
+  seqnode_t *pred, *curr;
+
+#ifdef CURSOR
+  curr = list->pred;
+#else
+  curr = list->head;
+#endif
+#ifdef DOUBLY
+  INC(list->cons);
+  while (key<curr->key) {
+    curr = curr->prev;
+    INC(list->cons);
+  }
+#else
+  if (curr->key>=key) curr = list->head;
+#endif
+  pred = curr;
+  while (key>curr->key) {
+    pred = curr; curr = curr->next;
+    INC(list->cons);
+  }
+
+#if defined(CURSOR) && defined(DOUBLY)
+  list->pred = curr;
+#elif defined(CURSOR)
+  list->pred = pred;
+#endif
+  (void)pred; // the cursor of the singly linked list only
+  
+  return (curr->key==key);
+}
+
+void seqload(long keys[], int n, seqlist_t *list)
+{
+  seqnode_t *pred, *node;
+  int i;
+
+  pred = list->head;
+  for (i = 0; i < n; i++) {
+    node = (seqnode_t*)slaballoc(&list->slab);
+    node->key = keys[i];
+    node->prev = pred;
+    pred->next = node;
+    pred = node;
+  }
+  pred->next = list->tail;
+  list->tail->prev = pred;
+}
+
+long seqcount(long lo, long hi, seqlist_t *list)
+{
+  seqnode_t *curr;
+  long n;
+
+  if (lo==LONG_MIN) lo++; // the head
+  seqpos(lo,list);
+  n = 0;
+  for (curr = list->curr; curr != list->tail && curr->key <= hi; curr = curr->next) {
+    n++;
+    INC(list->trav);
+  }
+
+  return n;
+}
+
+#ifdef SEQUENTIAL
+// the interface of linkedlist.h on the sequential list
+void create(node_t *head, node_t *tail)
+{
+  seqcreate(head,tail);
+}
+
+void destroy(node_t *head, node_t *tail)
+{
+}
+
+void init(node_t *head, node_t *tail, list_t *list)
+{
+  seqinit(head,tail,list);
+  list->shard = &list->own;
+  list->own.adds = 0;
+  list->own.rems = 0;
+
+#ifdef COUNTERS
+  list->fail = 0;
+  list->rtry = 0;
+  list->upds = 0;
+  list->pubs = 0;
+  list->hits = 0;
+  list->elim = 0;
+#endif
+}
+
+void clean(list_t *list)
+{
+  seqclean(list);
+}
+
+int add(long key, list_t *list)
+{
+  int res;
+
+  res = seqadd(key,list);
+  ADDED(list,res);
+  return res;
+}
+
+int rem(long key, list_t *list)
+{
+  int res;
+
+  res = seqrem(key,list);
+  REMOVED(list,res);
+  return res;
+}
+
+int con(long key, list_t *list)
+{
+  return seqcon(key,list);
+}
+
+// sequential: team is ignored, the list is private
+void load(long keys[], int n, int team, list_t *list)
+{
+  seqload(keys,n,list);
+  ADDED(list,n);
+}
+
+// one operation per key
+void add_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = add(keys[i], list);
+}
+
+void rem_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = rem(keys[i], list);
+}
+
+void con_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = con(keys[i], list);
+}
+
+void range(long lo, long hi, iter_t *iter, list_t *list)
+{
+  node_t *curr;
+
+  curr = list->head->next;
+  while (curr->key < lo) {
+    curr = curr->next;
+    INC(list->trav);
+  }
+  iter->list = list;
+  iter->curr = curr;
+  iter->lo = lo;
+  iter->hi = hi;
+}
+
+int rangenext(iter_t *iter, long *key)
+{
+  if (iter->curr == iter->list->tail || iter->curr->key > iter->hi)
+    return 0;
+
+  *key = iter->curr->key;
+  iter->curr = iter->curr->next;
+  INC(iter->list->trav);
+
+  return 1;
+}
+
+void rangedone(iter_t *iter)
+{
+}
+#endif
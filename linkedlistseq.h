@@ -0,0 +1,41 @@
+/* The sequential list of linkedlistseq.c: no atomics, no marks, one thread */
+/* The baseline of the speedup and efficiency reported by listbench */
+
+#ifndef LINKEDLISTSEQ_H
+#define LINKEDLISTSEQ_H
+
+#include "slab.h"
+
+// DOUBLY and CURSOR as for the concurrent list. With SEQUENTIAL (the
+// lsequential executables) these are the nodes of the plain SEQUENTIAL
+// layout and the lists of linkedlist.h, to be included before, and
+// linkedlistseq.c implements its interface.
+#ifdef SEQUENTIAL
+typedef node_t seqnode_t;
+typedef list_t seqlist_t;
+#else
+typedef struct _seqnode {
+  struct _seqnode *next;
+  long key;
+  struct _seqnode *prev;
+} seqnode_t;
+
+typedef struct _seqlist {
+  seqnode_t *head, *tail;
+  seqnode_t *pred, *curr; // of the last operation, pred the cursor
+  slab_t slab;
+  unsigned long long adds, rems, cons, trav;
+} seqlist_t;
+#endif
+
+void seqcreate(seqnode_t *head, seqnode_t *tail);
+void seqinit(seqnode_t *head, seqnode_t *tail, seqlist_t *list);
+void seqclean(seqlist_t *list); // releases all nodes
+
+int seqadd(long key, seqlist_t *list);
+int seqrem(long key, seqlist_t *list);
+int seqcon(long key, seqlist_t *list);
+void seqload(long keys[], int n, seqlist_t *list); // sorted, distinct, into the empty list
+long seqcount(long lo, long hi, seqlist_t *list);  // keys in [lo,hi]
+
+#endif
@@ -1,406 +1,1591 @@
-/* (C) Jesper Larsson Traff, May 2020 */
-
-#include <stdio.h>
-#include <stdlib.h>
-
-#include <assert.h>
-
-#include <omp.h>
-
-#include "linkedlist.h"
-
-#define N 10000
-
-//#define PRIVATE
-
-#define MICRO 1000000.0
-#define MILLI 1000.0
-#define KOPS  1000
-
-//#define TEST(_A) assert(_A) // just _A when shared with overlap
-#define TEST(_A) if (!(_A)) printf("Line %d: t %d key %ld\n",__LINE__,t,key)
-//#define TEST(_A) assert( _A)
-
-// stress linearity benchmark
-void benchmark1(int n, int p, int ar, int ao, int rr, int ro, int verbose,
-		int latex)
-{
-  double time;
-  int disjoint;
-
-  disjoint = (ar==rr&&ao==ro)&&((ar==p)||(ar==1&&ao==n));
-
-  time = 0.0;
-  
-  // performance counters
-#ifdef COUNTERS
-  unsigned long long tops, adds, rems, cons, trav, fail, rtry;
-
-  tops = 0;
-
-  adds = 0;
-  rems = 0;
-  cons = 0;
-  trav = 0;
-  fail = 0;
-  rtry = 0;
-#endif
-  
-#ifndef PRIVATE
-  node_t head, tail; // shared list
-#endif    
-
-#ifndef PRIVATE
-#pragma omp parallel shared(head) shared(tail) reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail)
-#else
-#pragma omp parallel reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail)
-#endif  
-  {
-    double start, stop;
-#ifdef PRIVATE
-    node_t head, tail;
-#endif
-    list_t list;
-
-#ifdef COUNTERS
-    int ops = 0;
-#endif
-    int t = omp_get_thread_num();
-    long key;
-
-    init(&head,&tail,&list);
-    
-#pragma omp barrier
-    start = omp_get_wtime();
-    
-    int i;
-    int ok;
-    for (i=0; i<n; i++) {
-      key = i;
-      key = key*ar+t*ao+t%ar;
-      ok = !con(key,&list); INC(ops);
-      TEST(!disjoint||ok);  
-      ok = add(key,&list);  INC(ops);
-      TEST(!disjoint||ok);
-      ok = con(key,&list);  INC(ops);
-      TEST(!disjoint||ok);
-      ok = !add(key,&list); INC(ops);
-      TEST(!disjoint||ok);
-    }
-
-    for (i=n-1; i>=0; i--) {
-      key = i;
-      key = key*ar+t*ao+t%ar;
-      ok = con(key,&list);  INC(ops);
-      TEST(!disjoint||ok);
-      ok = rem(key,&list);  INC(ops);
-      TEST(!disjoint||ok);
-      ok = !con(key,&list); INC(ops);
-      TEST(!disjoint||ok);
-      ok = !rem(key,&list); INC(ops);
-      TEST(!disjoint||ok);
-    }
-
-    for (i=0; i<n; i++) {
-      key = i;
-      key = key*ar+t*ao+t%ar;
-      ok = !con(key,&list); INC(ops);
-      TEST(!disjoint||ok);
-    }
-
-    stop = omp_get_wtime();
-#pragma omp barrier
-    if (time<stop-start) time = stop-start;
-    
-    tops += ops;
-
-    adds += list.adds;
-    rems += list.rems;
-    cons += list.cons;
-    trav += list.trav;
-    fail += list.fail;
-    rtry += list.rtry;
-    if (verbose) {
-      printf("DET Thread %d: ops %d adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
-	     t,ops,list.adds,list.rems,list.cons,list.trav,list.fail,list.rtry);
-    }
-
-    clean(&list);
-  }
-
-  printf("DET Threads: %d\n",p);
-  if (latex) {
-    printf("Time (ms) & Total ops & Throughput (Kops/s) & adds & rems & cons& trav & fail & rtry \\\\\n");
-    printf("%.2f & %llu & %.2f & %llu & %llu & %llu & %llu & %llu & %llu \\\\\n",
-	   time*MILLI,tops,((double)tops/time)/KOPS,
-	   adds,rems,cons,trav,fail,rtry);
-  } else {
-    printf("Time (ms) %.2f Total ops %llu Throughput (Kops/s) %.2f\n",
-	   time*MILLI,tops,((double)tops/time)/KOPS);
-    printf("adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
-	   adds,rems,cons,trav,fail,rtry);
-  }
-}
-
-// random mix
-void benchmark2(int n, int p, int f, int U, int pa, int pr, unsigned seed,
-		int verbose, int latex, int csv)
-{
-  double time;
-
-  time = 0.0;
-  
-  // performance counters
-#ifdef COUNTERS
-  unsigned long long tops, adds, rems, cons, trav, fail, rtry;
-
-  tops = 0;
-  
-  adds = 0;
-  rems = 0;
-  cons = 0;
-  trav = 0;
-  fail = 0;
-  rtry = 0;
-#endif
-  
-#ifndef PRIVATE
-  node_t head, tail; // shared list
-#endif
-
-#ifdef PRIVATE
-#pragma omp parallel reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail)
-#else
-#pragma omp parallel shared(head) shared(tail) reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail)
-#endif
-  {
-    double start, stop;
-#ifdef PRIVATE
-    node_t head, tail;
-#endif
-
-    list_t list;
-    int i;
-
-    int t = omp_get_thread_num();
-
-#ifdef COUNTERS
-    int ops = 0;
-#endif
-    
-#if defined(sun) || defined(__sun)
-    // Solaris does not support random_r
-    srand(seed + t);
-#else
-    struct random_data rbuf;
-    char rstate[32];
-    
-    rbuf.state = NULL;
-    initstate_r(seed+t,rstate,32,&rbuf);
-#endif
-
-    long key;
-
-    init(&head,&tail,&list);
-
-    // prefill
-#ifndef PRIVATE
-#pragma single nowait
-#endif
-    {
-      int k;
-      for (i=0; i<f; i++) {
-#if defined(sun) || defined(__sun)      
-        k = rand();
-#else
-        random_r(&rbuf,&k);
-#endif
-        key = k%U;
-        add(key,&list);
-      }
-    
-      list.adds = 0;
-      list.rems = 0;
-      list.cons = 0;
-      list.trav = 0;
-      list.fail = 0;
-      list.rtry = 0;
-    }
-    
-#pragma omp barrier
-    start = omp_get_wtime();
-    
-    int op, k;
-    for (i=0; i<n; i++) {
-#if defined(sun) || defined(__sun)      
-      k = rand();
-#else
-      random_r(&rbuf,&k);
-#endif
-      key = k%U;
-
-#if defined(sun) || defined(__sun)      
-      op = rand();
-#else
-      random_r(&rbuf,&op);
-#endif
-      op = op%100;
-      if (op<pa) {
-	add(key,&list); INC(ops);
-      } else if (op<pa+pr) {
-	rem(key,&list); INC(ops);
-      } else {
-	con(key,&list); INC(ops);
-      }
-    }
-    
-    stop = omp_get_wtime();
-#pragma omp barrier
-    if (time<stop-start) time = stop-start;
-
-    tops += ops;
-    
-    adds += list.adds;
-    rems += list.rems;
-    cons += list.cons;
-    trav += list.trav;
-    fail += list.fail;
-    rtry += list.rtry;
-    if (verbose) {
-      printf("STEADY Thread %d: ops %d adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
-	     t,ops,list.adds,list.rems,list.cons,list.trav,list.fail,list.rtry);
-    }
-
-#ifndef PRIVATE
-#pragma omp single
-#endif
-    {
-      node_t *node = list.head->next;
-      while (node!=&tail) {
-	node_t *curr = node;
-	node = node->next;
-	free(curr);
-      }
-    }
-    
-    clean(&list);
-  }
-
-#if defined(TEXTBOOK)
-  char* benchmark = "draconic";
-#elif defined(CURSOR)
-#if defined(DOUBLY)
-  char* benchmark = "doubly_cursor";
-#else
-  char* benchmark = "singly_cursor";
-#endif
-#elif defined(DOUBLY)
-  char* benchmark = "doubly";
-#else
-  char* benchmark = "singly";
-#endif
-
-  printf("STEADY Threads: %d\n",p);
-  if (latex) {
-    printf("Time (ms) & Total ops & Throughput (Kops/s) & adds & rems & cons& trav & fail & rtry \\\\\n");
-    printf("%.2f & %llu & %.2f & %llu & %llu & %llu & %llu & %llu & %llu \\\\\n",
-	   time*MILLI,tops,((double)tops/time)/KOPS,
-	   adds,rems,cons,trav,fail,rtry);
-  } else if (csv) {
-    printf("Time (ms);Total ops;Throughput (Kops/s);adds;rems;cons;trav;fail;rtry;threads;benchmark\n");
-    printf("%.2f;%llu;%.2f;%llu;%llu;%llu;%llu;%llu;%llu;%d;%s\n",
-      time*MILLI, tops, ((double)tops/time)/KOPS, adds, rems, cons, trav, fail, rtry, p, benchmark);
-  } else {
-    printf("Time (ms) %.2f Total ops %llu Throughput (Kops/s) %.2f\n",
-	   time*MILLI,tops,((double)tops/time)/KOPS);
-    printf("adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
-	   adds,rems,cons,trav,fail,rtry);
-  }
-}
-
-int main(int argc, char *argv[])
-{
-  int i;
-
-  int p; // number of threads
-  
-  int n, f, c;
-  int ar, ao, rr, ro; // add and remove factors and offsets
-  int pa, pr; // percentage (integer) of adds and removes
-  int verbose, latex, csv;
-
-  int U;
-  unsigned seed;
-  char benchmark = '_'; // _ = both; D = deterministic; S = steady
-  
-  n = N;
-  f = N;
-  c = N;
-  
-  p = -1;
-
-  ar = -1;
-  ao = -1;
-  rr = -1;
-  ro = -1;
-
-  U = -1;
-  pa = 10; pr = 10; // 10% add, 10% rem
-  
-  verbose = 0;
-  latex = 0;
-  csv=0;
-  
-  for (i=1; i<argc&&argv[i][0]=='-'; i++) {
-    if (argv[i][1]=='h') {
-      printf("Quadratic benchmark:\n");
-      printf("-n\tNumber of elements\n");
-      printf("Randomized throughput benchmark:\n");
-      printf("-c\tNumber of operations\n");
-    }
-    if (argv[i][1]=='n') i++,sscanf(argv[i],"%d",&n); // number elements (deterministic benchmark)
-    if (argv[i][1]=='p') i++,sscanf(argv[i],"%d",&p); // number threads
-
-    if (argv[i][1]=='r') i++,sscanf(argv[i],"%d",&ar); // add factor
-    if (argv[i][1]=='o') i++,sscanf(argv[i],"%d",&ao); // add offset
-    if (argv[i][1]=='R') i++,sscanf(argv[i],"%d",&rr); // remove factor
-    if (argv[i][1]=='O') i++,sscanf(argv[i],"%d",&ro); // remove offset
-
-    if (argv[i][1]=='c') i++,sscanf(argv[i],"%d",&c); // number operations (randomized benchmark)
-    if (argv[i][1]=='f') i++,sscanf(argv[i],"%d",&f); // prefill
-    if (argv[i][1]=='U') i++,sscanf(argv[i],"%d",&U); // key-range (default 10*prefill)
-    if (argv[i][1]=='A') i++,sscanf(argv[i],"%d",&pa);
-    if (argv[i][1]=='R') i++,sscanf(argv[i],"%d",&pr);
-
-    if (argv[i][1]=='S') i++,sscanf(argv[i],"%d",&seed);
-    if (argv[i][1]=='V') verbose = 1;
-    if (argv[i][1]=='L') latex = 1;
-    if (argv[i][1]=='C') csv = 1;
-
-    if (argv[i][1]=='B') {
-       i++;
-      benchmark = argv[i][0];
-      if (benchmark != 'D' && benchmark != 'S')
-        benchmark = '_';
-    }
-  }
-
-  if (p<=0) p = omp_get_max_threads(); // default
-  else omp_set_num_threads(p);
-
-  if (benchmark == 'D' || benchmark == '_') {
-    if (ar==-1) ar = p;
-    if (ao==-1) ao = 0;
-    if (rr==-1) rr = p;
-    if (ro==-1) ro = 0;
-    benchmark1(n,p,ar,ao,rr,ro,verbose,latex);
-  }
-
-  if (benchmark == 'S' || benchmark == '_') {
-    assert(pa+pr<=100);
-    if (U==-1) U = 10*f;
-    benchmark2(c,p,f,U,pa,pr,seed,verbose,latex,csv);
-  }
-  
-  return 0;
-}
+/* (C) Jesper Larsson Traff, May 2020 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include <assert.h>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+#include "linkedlist.h"
+#include "linkedlistseq.h"
+#include "perfcount.h"
+#include "latency.h"
+#include "affinity.h"
+#include "workload.h"
+#include "history.h"
+
+#define N 10000
+
+//#define PRIVATE
+
+#define MICRO 1000000.0
+#define MILLI 1000.0
+#define KOPS  1000
+
+//#define TEST(_A) assert(_A) // just _A when shared with overlap
+#define TEST(_A) if (!(_A)) printf("Line %d: t %d key %ld\n",__LINE__,t,key)
+//#define TEST(_A) assert( _A)
+
+#ifdef POLICY
+// string keys (-K): strings of the keys [0,U), in another order
+#define STRLEN 17
+#define STR(_k) (strs+(_k)*STRLEN)
+int strstyle = STR_NONE;
+char *strs = NULL;
+#endif
+
+// ascending keys for qsort
+int keycmp(const void *a, const void *b)
+{
+  long x = *(const long*)a, y = *(const long*)b;
+
+  return (x > y)-(x < y);
+}
+
+// current and peak resident set size in MB
+void memusage(double *rss, double *peak)
+{
+  struct rusage usage;
+  long size, resident;
+  FILE *statm;
+
+  *rss = 0.0;
+  statm = fopen("/proc/self/statm","r");
+  if (statm!=NULL) {
+    if (fscanf(statm,"%ld %ld",&size,&resident)==2)
+      *rss = (double)resident*sysconf(_SC_PAGESIZE)/(1024*1024);
+    fclose(statm);
+  }
+
+  getrusage(RUSAGE_SELF,&usage);
+  *peak = usage.ru_maxrss/1024.0; // kilobytes on Linux
+  if (*peak<*rss) *peak = *rss;
+}
+
+// name of the list variant
+void variant(char *name)
+{
+#if defined(POLICY)
+  strcpy(name,policyname());
+  if (strstyle==STR_PLAIN) strcat(name,"_strcmp");
+  if (strstyle==STR_PREFIX) strcat(name,"_prefix");
+#elif defined(TEXTBOOK)
+  strcpy(name,"draconic");
+#else
+#if defined(DOUBLY)
+  strcpy(name,"doubly");
+#else
+  strcpy(name,"singly");
+#endif
+#if defined(CURSOR)
+  strcat(name,"_cursor");
+#endif
+#endif
+#if defined(UNROLLED)
+  strcat(name,"_unrolled");
+#endif
+#if defined(SKIP)
+  strcat(name,"_skip");
+#endif
+#if defined(FINGERS)
+  strcat(name,"_fingers");
+#endif
+#if defined(COMBINE)
+  strcat(name,"_combine");
+#endif
+#if defined(BACKOFF)
+  strcat(name,"_backoff");
+#endif
+#if defined(SPLITORDER)
+  strcpy(name,"hash");
+#endif
+#if defined(MAP)
+  strcat(name,"_map");
+#endif
+#if defined(EPOCH)
+  strcat(name,"_epoch");
+#elif defined(HAZARD)
+  strcat(name,"_hazard");
+#endif
+#if defined(LAYOUT_ALIGNED)
+  strcat(name,"_aligned");
+#elif defined(LAYOUT_DENSE)
+  strcat(name,"_dense");
+#elif defined(LAYOUT_SPLIT)
+  strcat(name,"_split");
+#endif
+#if defined(SEQUENTIAL) || defined(PRIVATE)
+  char base[64];
+  strcpy(base,name);
+#if defined(SEQUENTIAL)
+  sprintf(name,"sequential_%s",base);
+#else
+  sprintf(name,"private_%s",base);
+#endif
+#endif
+}
+
+// per operation count, or na if the counter was not available
+char *perop(char *buf, unsigned long long count, unsigned long long ops,
+	    int valid, char *na)
+{
+  if (valid) sprintf(buf,"%.2f",(double)count/ops);
+  else strcpy(buf,na);
+  return buf;
+}
+
+// a ratio to the sequential baseline, or na without one (NAN)
+char *ratio(char *buf, double r, char *na)
+{
+  if (!isnan(r)) sprintf(buf,"%.2f",r);
+  else strcpy(buf,na);
+  return buf;
+}
+
+// hardware events per operation and per traversal hop (trav+cons),
+// n/a (NA) if some thread could not count them
+void perfprint(unsigned long long hw[], int nohw[], unsigned long long ops, unsigned long long hops)
+{
+  char buf[5][32];
+
+  printf("cycles/op %s instructions/op %s branch misses/op %s IPC %s\n",
+	 perop(buf[0],hw[PERF_CYCLES],ops,!nohw[PERF_CYCLES],"n/a"),
+	 perop(buf[1],hw[PERF_INSTR],ops,!nohw[PERF_INSTR],"n/a"),
+	 perop(buf[2],hw[PERF_BRMISS],ops,!nohw[PERF_BRMISS],"n/a"),
+	 perop(buf[3],hw[PERF_INSTR],hw[PERF_CYCLES],!nohw[PERF_INSTR]&&!nohw[PERF_CYCLES]&&hw[PERF_CYCLES]>0,"n/a"));
+  printf("per hop: cycles %s instructions %s L1 misses %s LLC misses %s branch misses %s\n",
+	 perop(buf[0],hw[PERF_CYCLES],hops,!nohw[PERF_CYCLES]&&hops>0,"n/a"),
+	 perop(buf[1],hw[PERF_INSTR],hops,!nohw[PERF_INSTR]&&hops>0,"n/a"),
+	 perop(buf[2],hw[PERF_L1MISS],hops,!nohw[PERF_L1MISS]&&hops>0,"n/a"),
+	 perop(buf[3],hw[PERF_LLCMISS],hops,!nohw[PERF_LLCMISS]&&hops>0,"n/a"),
+	 perop(buf[4],hw[PERF_BRMISS],hops,!nohw[PERF_BRMISS]&&hops>0,"n/a"));
+}
+
+void perfcsv(unsigned long long hw[], int nohw[], unsigned long long ops, unsigned long long hops, int header)
+{
+  char buf[32];
+  int i;
+  const int op[] = {PERF_CYCLES,PERF_INSTR,PERF_BRMISS};
+  const int hop[] = {PERF_CYCLES,PERF_INSTR,PERF_L1MISS,PERF_LLCMISS,PERF_BRMISS};
+
+  if (header) {
+    printf("cycles/op;instructions/op;branch misses/op;");
+    printf("cycles/hop;instructions/hop;L1 misses/hop;LLC misses/hop;branch misses/hop;");
+    return;
+  }
+  for (i=0; i<3; i++)
+    printf("%s;",perop(buf,hw[op[i]],ops,!nohw[op[i]],"NA"));
+  for (i=0; i<5; i++)
+    printf("%s;",perop(buf,hw[hop[i]],hops,!nohw[hop[i]]&&hops>0,"NA"));
+}
+
+// latency percentiles of the timed operations of each type
+const char *latnames[LATOPS] = {"add","rem","con"};
+const double latqs[] = {0.5,0.9,0.99,0.999};
+#define LATQS 4
+
+void latprint(latency_t *lat, int latex)
+{
+  int op, q;
+
+  if (latperiod==0) return;
+  if (latex) {
+    printf("Operation & Timed & p50 (ns) & p90 (ns) & p99 (ns) & p99.9 (ns) & max (ns) \\\\\n");
+    for (op=0; op<LATOPS; op++) {
+      printf("%s & %llu",latnames[op],latsamples(lat,op));
+      for (q=0; q<LATQS; q++) printf(" & %.0f",latpercentile(lat,op,latqs[q]));
+      printf(" & %.0f \\\\\n",latmax(lat,op));
+    }
+  } else {
+    printf("Latency (ns) of one in %d operations on average:\n",latperiod);
+    for (op=0; op<LATOPS; op++) {
+      printf("%s timed %llu",latnames[op],latsamples(lat,op));
+      for (q=0; q<LATQS; q++) printf(" p%g %.0f",latqs[q]*100,latpercentile(lat,op,latqs[q]));
+      printf(" max %.0f\n",latmax(lat,op));
+    }
+  }
+}
+
+// CSV columns, NA without timing
+void latcsv(latency_t *lat, int header)
+{
+  int op, q;
+
+  for (op=0; op<LATOPS; op++) {
+    for (q=0; q<LATQS; q++) {
+      if (header) printf("%s p%g (ns);",latnames[op],latqs[q]*100);
+      else if (latperiod==0) printf("NA;");
+      else printf("%.0f;",latpercentile(lat,op,latqs[q]));
+    }
+    if (header) printf("%s max (ns);",latnames[op]);
+    else if (latperiod==0) printf("NA;");
+    else printf("%.0f;",latmax(lat,op));
+  }
+}
+
+// thread and memory placement
+int sockets = 1;
+
+void placeprint(void)
+{
+  char cpus[256];
+
+  printf("Pinning: %s, CPUs %s, %d sockets\n",pinnames[pinpolicy],pinstring(cpus,sizeof(cpus)),sockets);
+  if (slabpolicy==SLAB_BIND) printf("Memory: bind to node %d of %d\n",slabnode,slabnodes());
+  else printf("Memory: %s, %d NUMA nodes\n",slabnames[slabpolicy],slabnodes());
+}
+
+void placecsv(int header)
+{
+  char cpus[256];
+
+  if (header) printf("pinning;cpus;sockets;memory;numa nodes;");
+  else if (slabpolicy==SLAB_BIND)
+    printf("%s;%s;%d;bind:%d;%d;",pinnames[pinpolicy],pinstring(cpus,sizeof(cpus)),sockets,slabnode,slabnodes());
+  else
+    printf("%s;%s;%d;%s;%d;",pinnames[pinpolicy],pinstring(cpus,sizeof(cpus)),sockets,slabnames[slabpolicy],slabnodes());
+}
+
+#ifdef POLICY
+// name is in the comma separated names, or names is all
+int listed(const char *name, const char *names)
+{
+  size_t len = strlen(name);
+  const char *s;
+
+  if (strcmp(names,"all")==0) return 1;
+  for (s = names; s != NULL; s = strchr(s,',')) {
+    if (*s==',') s++;
+    if (strncmp(s,name,len)==0 && (s[len]==',' || s[len]=='\0')) return 1;
+  }
+  return 0;
+}
+#endif
+
+// the baseline of the speedup: the operations of a run on the sequential
+// list of linkedlistseq.c by the calling thread, after the run; only for
+// the list variants, not for the index, hash set, unrolled nodes, fingers
+// or run time policies, which the sequential list does not implement
+#if defined(SKIP) || defined(SPLITORDER) || defined(UNROLLED) || defined(FINGERS) || defined(POLICY)
+#define NOBASELINE
+#endif
+
+#ifndef NOBASELINE
+
+// deterministic: the operations of all threads, phase by phase, the
+// threads one after the other; on one list per thread if PRIVATE; the time
+double baseline1(int n, int p, int ar, int ao)
+{
+#ifdef PRIVATE
+  int lists = p;
+#else
+  int lists = 1;
+#endif
+  seqnode_t *sentinels = (seqnode_t*)malloc(2*lists*sizeof(seqnode_t));
+  seqlist_t *list = (seqlist_t*)malloc(lists*sizeof(seqlist_t));
+  double start, stop;
+  long key;
+  int t, i, l;
+
+  for (l=0; l<lists; l++) {
+    seqcreate(&sentinels[2*l],&sentinels[2*l+1]);
+    seqinit(&sentinels[2*l],&sentinels[2*l+1],&list[l]);
+  }
+
+  start = omp_get_wtime();
+  for (t=0; t<p; t++) {
+    for (i=0; i<n; i++) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      seqcon(key,&list[t%lists]);
+      seqadd(key,&list[t%lists]);
+      seqcon(key,&list[t%lists]);
+      seqadd(key,&list[t%lists]);
+#ifdef MAP
+      seqcon(key,&list[t%lists]); // update, update, get
+      seqcon(key,&list[t%lists]);
+      seqcon(key,&list[t%lists]);
+#endif
+    }
+  }
+  for (t=0; t<p; t++) {
+    for (i=n-1; i>=0; i--) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      seqcon(key,&list[t%lists]);
+      seqrem(key,&list[t%lists]);
+      seqcon(key,&list[t%lists]);
+      seqrem(key,&list[t%lists]);
+    }
+  }
+  for (t=0; t<p; t++) {
+    for (i=0; i<n; i++) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      seqcon(key,&list[t%lists]);
+    }
+  }
+  stop = omp_get_wtime();
+
+  for (l=0; l<lists; l++) seqclean(&list[l]);
+  free(sentinels);
+  free(list);
+
+  return stop-start;
+}
+
+// steady: the prefill and mix of thread 0, ops operations (the share of a
+// thread), updates as lookups; the throughput in operations per second
+double baseline2(long ops, int p, int f, int U, int pa, int pr, int pu, int ps, int sl, int batch,
+                 const workload_t *wl, unsigned seed)
+{
+  seqnode_t head, tail;
+  seqlist_t list;
+  gen_t gen;
+  double start, stop;
+  long *pkeys = (long*)malloc(f*sizeof(long));
+  long *bkeys = (long*)malloc(batch*sizeof(long));
+  long i, key;
+  int u, pf, op, j;
+
+  genseed(&gen,wl,seed,0,p);
+  seqcreate(&head,&tail);
+  seqinit(&head,&tail,&list);
+  pf = 0;
+  for (u=0; u<U && pf<f; u++) {
+    if (genrand(&gen)%(U-u)<(unsigned)(f-pf)) pkeys[pf++] = u;
+  }
+  seqload(pkeys,pf,&list);
+  if (ops<1) ops = 1;
+
+  start = omp_get_wtime();
+  for (i=0; i<ops; i++) {
+    key = genkey(&gen);
+    op = genint(&gen,100);
+    if (batch>1 && (op<pa+pr || op>=pa+pr+pu+ps)) {
+      bkeys[0] = key;
+      for (j=1; j<batch; j++) bkeys[j] = genkey(&gen);
+      qsort(bkeys,batch,sizeof(long),keycmp);
+      for (j=0; j<batch; j++) {
+        if (op<pa) seqadd(bkeys[j],&list);
+        else if (op<pa+pr) seqrem(bkeys[j],&list);
+        else seqcon(bkeys[j],&list);
+      }
+      i += batch-1;
+    } else if (op<pa) {
+      seqadd(key,&list);
+    } else if (op<pa+pr) {
+      seqrem(key,&list);
+    } else if (op>=pa+pr+pu && op<pa+pr+pu+ps) {
+      seqcount(key,key+sl-1,&list);
+    } else {
+      seqcon(key,&list);
+    }
+  }
+  stop = omp_get_wtime();
+
+  seqclean(&list);
+  free(pkeys);
+  free(bkeys);
+
+  return i/(stop-start);
+}
+#endif // NOBASELINE
+
+// stress linearity benchmark
+void benchmark1(int n, int p, int ar, int ao, int rr, int ro, int verbose,
+		int latex, int csv)
+{
+  double time;
+  int disjoint;
+
+  disjoint = (ar==rr&&ao==ro)&&((ar==p)||(ar==1&&ao==n));
+
+  time = 0.0;
+  
+  // performance counters
+#ifdef COUNTERS
+  unsigned long long tops, adds, rems, cons, trav, fail, rtry;
+  unsigned long long hw[PERFEVENTS]; // hardware events
+  int nohw[PERFEVENTS];              // not counted by some thread
+  char l1buf[32], llcbuf[32];
+  int e;
+
+  tops = 0;
+  for (e=0; e<PERFEVENTS; e++) {
+    hw[e] = 0;
+    nohw[e] = 0;
+  }
+
+  adds = 0;
+  rems = 0;
+  cons = 0;
+  trav = 0;
+  fail = 0;
+  rtry = 0;
+#endif
+  
+  latency_t *lat = (latency_t*)malloc(sizeof(latency_t)); // of all threads
+  latinit(lat);
+
+#ifndef PRIVATE
+  node_t head, tail; // shared list
+  create(&head,&tail);
+#endif    
+
+#ifndef PRIVATE
+#pragma omp parallel shared(head) shared(tail) reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail,rtry,hw[:PERFEVENTS]) reduction(|:nohw[:PERFEVENTS])
+#else
+#pragma omp parallel reduction(max:time) reduction(+:tops,adds,rems,cons,trav,fail,rtry,hw[:PERFEVENTS]) reduction(|:nohw[:PERFEVENTS])
+#endif  
+  {
+    double start, stop;
+#ifdef PRIVATE
+    node_t head, tail;
+#endif
+    list_t list;
+
+#ifdef COUNTERS
+    int ops = 0;
+#endif
+    int t = omp_get_thread_num();
+    long key;
+
+    pin(t);
+
+#ifdef PRIVATE
+    create(&head,&tail);
+#endif
+    init(&head,&tail,&list);
+    latency_t *tlat = (latency_t*)malloc(sizeof(latency_t));
+    latinit(tlat);
+    
+    perf_t perf;
+    perfopen(&perf);
+
+#pragma omp barrier
+    start = omp_get_wtime();
+    perfstart(&perf);
+    
+    int i;
+    int ok;
+    for (i=0; i<n; i++) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      ok = !TIMED(tlat,LAT_CON,con(key,&list)); INC(ops);
+      TEST(!disjoint||ok);  
+      ok = TIMED(tlat,LAT_ADD,add(key,&list));  INC(ops);
+      TEST(!disjoint||ok);
+      ok = TIMED(tlat,LAT_CON,con(key,&list));  INC(ops);
+      TEST(!disjoint||ok);
+      ok = !TIMED(tlat,LAT_ADD,add(key,&list)); INC(ops);
+      TEST(!disjoint||ok);
+#ifdef MAP
+      long value;
+      ok = update(key,0,key+1,&list); INC(ops);
+      TEST(!disjoint||ok);
+      ok = !update(key,0,key+1,&list); INC(ops);
+      TEST(!disjoint||ok);
+      ok = get(key,&value,&list)&&value==key+1; INC(ops);
+      TEST(!disjoint||ok);
+#endif
+    }
+
+    for (i=n-1; i>=0; i--) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      ok = TIMED(tlat,LAT_CON,con(key,&list));  INC(ops);
+      TEST(!disjoint||ok);
+      ok = TIMED(tlat,LAT_REM,rem(key,&list));  INC(ops);
+      TEST(!disjoint||ok);
+      ok = !TIMED(tlat,LAT_CON,con(key,&list)); INC(ops);
+      TEST(!disjoint||ok);
+      ok = !TIMED(tlat,LAT_REM,rem(key,&list)); INC(ops);
+      TEST(!disjoint||ok);
+    }
+
+    for (i=0; i<n; i++) {
+      key = i;
+      key = key*ar+t*ao+t%ar;
+      ok = !TIMED(tlat,LAT_CON,con(key,&list)); INC(ops);
+      TEST(!disjoint||ok);
+    }
+
+    perfstop(&perf);
+    stop = omp_get_wtime();
+#pragma omp barrier
+    if (time<stop-start) time = stop-start;
+    
+    tops += ops;
+
+    adds += list.adds;
+    rems += list.rems;
+    cons += list.cons;
+    trav += list.trav;
+    fail += list.fail;
+    rtry += list.rtry;
+    for (e=0; e<PERFEVENTS; e++) {
+      hw[e] += perf.count[e];
+      nohw[e] |= perf.fd[e]<0;
+    }
+    perfclose(&perf);
+#pragma omp critical
+    latmerge(lat,tlat);
+    free(tlat);
+    if (verbose) {
+      printf("DET Thread %d: ops %d adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
+	     t,ops,list.adds,list.rems,list.cons,list.trav,list.fail,list.rtry);
+    }
+
+    clean(&list);
+#ifdef PRIVATE
+    destroy(&head,&tail);
+#endif
+  }
+#ifndef PRIVATE
+  destroy(&head,&tail);
+#endif
+#ifdef NOBASELINE
+  double base = NAN, speedup = NAN;
+#else
+  double base = baseline1(n,p,ar,ao); // sequential
+  double speedup = base/time;
+#endif
+  char basebuf[32], spbuf[32], effbuf[32];
+
+  char benchmark[64];
+  variant(benchmark);
+
+  printf("DET Threads: %d\n",p);
+  if (latex) {
+    printf("Time (ms) & Total ops & Throughput (Kops/s) & Speedup & Efficiency & adds & rems & cons& trav & fail & rtry \\\\\n");
+    printf("%.2f & %llu & %.2f & %s & %s & %llu & %llu & %llu & %llu & %llu & %llu \\\\\n",
+	   time*MILLI,tops,((double)tops/time)/KOPS,ratio(spbuf,speedup,"n/a"),ratio(effbuf,speedup/p,"n/a"),
+	   adds,rems,cons,trav,fail,rtry);
+    latprint(lat,latex);
+  } else if (csv) {
+    printf("Time (ms);Total ops;Throughput (Kops/s);adds;rems;cons;trav;fail;rtry;hops/op;L1 misses/op;LLC misses/op;");
+    perfcsv(hw,nohw,tops,trav+cons,1);
+    latcsv(lat,1);
+    placecsv(1);
+    printf("baseline (ms);speedup;efficiency;threads;benchmark\n");
+    printf("%.2f;%llu;%.2f;%llu;%llu;%llu;%llu;%llu;%llu;%.2f;%s;%s;",
+      time*MILLI, tops, ((double)tops/time)/KOPS, adds, rems, cons, trav, fail, rtry,
+      (double)(trav+cons)/tops, perop(l1buf,hw[PERF_L1MISS],tops,!nohw[PERF_L1MISS],"NA"), perop(llcbuf,hw[PERF_LLCMISS],tops,!nohw[PERF_LLCMISS],"NA"));
+    perfcsv(hw,nohw,tops,trav+cons,0);
+    latcsv(lat,0);
+    placecsv(0);
+    printf("%s;%s;%s;%d;%s\n",ratio(basebuf,base*MILLI,"NA"),ratio(spbuf,speedup,"NA"),ratio(effbuf,speedup/p,"NA"),p,benchmark);
+  } else {
+    printf("Time (ms) %.2f Total ops %llu Throughput (Kops/s) %.2f\n",
+	   time*MILLI,tops,((double)tops/time)/KOPS);
+    printf("Sequential (ms) %s Speedup %s Efficiency %s\n",
+	   ratio(basebuf,base*MILLI,"n/a"),ratio(spbuf,speedup,"n/a"),ratio(effbuf,speedup/p,"n/a"));
+    printf("adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu\n",
+	   adds,rems,cons,trav,fail,rtry);
+    printf("hops/op %.2f L1 misses/op %s LLC misses/op %s\n",
+	   (double)(trav+cons)/tops,
+	   perop(l1buf,hw[PERF_L1MISS],tops,!nohw[PERF_L1MISS],"n/a"),
+	   perop(llcbuf,hw[PERF_LLCMISS],tops,!nohw[PERF_LLCMISS],"n/a"));
+    perfprint(hw,nohw,tops,trav+cons);
+    latprint(lat,latex);
+  }
+  free(lat);
+}
+
+// duration mode (-d): operations for a time after a warm-up, with a
+// time series of the counters of each thread, one sample per interval
+#define TICKS 64 // iterations between reads of the clock
+
+double duration = 0.0, warmup = 0.0, interval = 0.1; // seconds
+FILE *series = NULL; // -z, CSV
+
+typedef struct _sample {
+  int phase;         // 0 warm-up, 1 timed
+  double time, span; // since the start, at the end of the interval
+  unsigned long long ops, adds, rems, cons, trav, fail, rtry;
+  long size;
+  double rss;
+} sample_t;
+
+// counters since the last sample
+void sample(sample_t *s, sample_t *last, unsigned long long ops, list_t *list, stats_t *stats)
+{
+  double peak;
+
+  s->ops = ops-last->ops;
+  s->adds = list->adds-last->adds;
+  s->rems = list->rems-last->rems;
+  s->cons = list->cons-last->cons;
+  s->trav = list->trav-last->trav;
+  s->fail = list->fail-last->fail;
+  s->rtry = list->rtry-last->rtry;
+  s->size = size(stats);
+  memusage(&s->rss,&peak);
+
+  last->ops = ops;
+  last->adds = list->adds;
+  last->rems = list->rems;
+  last->cons = list->cons;
+  last->trav = list->trav;
+  last->fail = list->fail;
+  last->rtry = list->rtry;
+}
+
+void seriescsv(sample_t *samples[], int nsamples[], int p, const char *benchmark)
+{
+  sample_t *s;
+  int t, k;
+
+  for (t=0; t<p; t++) {
+    for (k=0; k<nsamples[t]; k++) {
+      s = &samples[t][k];
+      fprintf(series,"%d;%.3f;%s;%.3f;%llu;%.2f;%llu;%llu;%llu;%llu;%llu;%llu;%.2f;%ld;%.1f;%d;%d;%s\n",
+        k, s->time, s->phase ? "timed" : "warm-up", s->span, s->ops, ((double)s->ops/s->span)/KOPS,
+        s->adds, s->rems, s->cons, s->trav, s->fail, s->rtry,
+        (s->ops>0) ? (double)(s->trav+s->cons)/s->ops : 0.0, s->size, s->rss, t, p, benchmark);
+    }
+  }
+  fflush(series);
+}
+
+void resetcounters(list_t *list)
+{
+  list->adds = 0;
+  list->rems = 0;
+  list->cons = 0;
+  list->trav = 0;
+  list->fail = 0;
+  list->rtry = 0;
+  list->upds = 0;
+  list->pubs = 0;
+  list->hits = 0;
+  list->elim = 0;
+}
+
+// the summary of a steady run for a sweep (-N)
+#define METRICS 7
+const char *metricnames[METRICS] = {"Throughput (Kops/s)","hops/op","conflicts/op","size","RSS (MB)","speedup","efficiency"};
+const char *metrickeys[METRICS] = {"throughput","hops","conflicts","size","rss","speedup","efficiency"};
+
+typedef struct _result {
+  double metric[METRICS];
+} result_t;
+
+// random mix
+void benchmark2(int n, int p, int f, int U, int pa, int pr, int pu, int ps, int sl, int batch, const workload_t *wl, unsigned seed,
+		int verbose, int latex, int csv, result_t *result)
+{
+  double time, btime; // operations, prefill
+  double rss, peak; // memory after the timed region
+
+  time = 0.0;
+  btime = 0.0;
+  
+  // performance counters
+#ifdef COUNTERS
+  unsigned long long tops, adds, rems, cons, trav, fail, rtry, upds, pubs, hits, elim;
+  unsigned long long scans, skeys; // range scans and keys found
+  unsigned long long hw[PERFEVENTS]; // hardware events
+  int nohw[PERFEVENTS];              // not counted by some thread
+  char l1buf[32], llcbuf[32];
+  int e;
+
+  tops = 0;
+  for (e=0; e<PERFEVENTS; e++) {
+    hw[e] = 0;
+    nohw[e] = 0;
+  }
+  
+  adds = 0;
+  rems = 0;
+  cons = 0;
+  trav = 0;
+  fail = 0;
+  rtry = 0;
+  upds = 0;
+  pubs = 0;
+  hits = 0;
+  elim = 0;
+  scans = 0;
+  skeys = 0;
+#endif
+  latency_t *lat = (latency_t*)malloc(sizeof(latency_t)); // of all threads
+  latinit(lat);
+  long items = 0; // size of the list(s) from the sharded counters
+  unsigned long long sadds = 0, srems = 0; // counted there in the timed region
+  
+#ifndef PRIVATE
+  node_t head, tail; // shared list
+  create(&head,&tail);
+  stats_t *stats = statscreate();
+
+  long *pkeys = (long*)malloc(f*sizeof(long)); // prefill
+  int pf;
+#endif
+  sample_t **samples = (sample_t**)calloc(p,sizeof(sample_t*)); // of each thread
+  int *nsamples = (int*)calloc(p,sizeof(int));
+  int maxsamples = (duration>0.0) ? (int)((warmup+duration)/interval)+2 : 0;
+  int th;
+
+#ifdef PRIVATE
+#pragma omp parallel reduction(max:time,btime) reduction(+:tops,adds,rems,cons,trav,fail,rtry,upds,pubs,hits,elim,scans,skeys,hw[:PERFEVENTS],items,sadds,srems) reduction(|:nohw[:PERFEVENTS])
+#else
+#pragma omp parallel shared(head) shared(tail) reduction(max:time,btime) reduction(+:tops,adds,rems,cons,trav,fail,rtry,upds,pubs,hits,elim,scans,skeys,hw[:PERFEVENTS],items,sadds,srems) reduction(|:nohw[:PERFEVENTS])
+#endif
+  {
+    double start, stop;
+#ifdef PRIVATE
+    node_t head, tail;
+#endif
+
+    list_t list;
+    long i;
+
+    int t = omp_get_thread_num();
+
+    pin(t);
+#ifdef COUNTERS
+    unsigned long long ops = 0;
+#endif
+    
+    gen_t gen; // keys and operations
+    genseed(&gen,wl,seed,t,p);
+
+    long key = 0; // for TEST, also after no operations
+
+#ifdef PRIVATE
+    create(&head,&tail);
+    stats_t *stats = statscreate();
+#endif
+    init(&head,&tail,&list);
+    attach(stats,&list);
+    latency_t *tlat = (latency_t*)malloc(sizeof(latency_t));
+    latinit(tlat);
+
+#ifdef PRIVATE
+    long *pkeys = (long*)malloc(f*sizeof(long));
+    int pf;
+#endif
+    double bstart, bstop;
+
+    // prefill: f distinct random keys in order (selection sampling),
+    // linked by load(), on a shared list by all threads
+#ifndef PRIVATE
+#pragma omp single
+#endif
+    {
+      int u;
+      pf = 0;
+      for (u=0; u<U && pf<f; u++) {
+        if (genrand(&gen)%(U-u)<(unsigned)(f-pf)) pkeys[pf++] = u;
+      }
+    }
+
+#pragma omp barrier
+    bstart = omp_get_wtime();
+#ifdef POLICY
+    if (strs!=NULL) {
+      // not sorted as strings: added by all threads
+#pragma omp for schedule(static)
+      for (i=0; i<pf; i++)
+        addstr(STR(pkeys[i]),&list);
+    } else
+#endif
+#ifdef PRIVATE
+    load(pkeys,pf,0,&list);
+#else
+    load(pkeys,pf,1,&list);
+#endif
+    bstop = omp_get_wtime();
+    if (btime<bstop-bstart) btime = bstop-bstart;
+#ifdef PRIVATE
+    free(pkeys);
+#endif
+
+    resetcounters(&list);
+    
+    perf_t perf;
+    perfopen(&perf);
+    sample_t last, *tsamples = NULL;
+    memset(&last,0,sizeof(last));
+    if (maxsamples>0) tsamples = (sample_t*)malloc(maxsamples*sizeof(sample_t));
+    int ns = 0, warm = (warmup>0.0);
+    unsigned tick = 0;
+
+#pragma omp barrier
+    start = omp_get_wtime();
+    double begin = start, next = start+interval, now;
+    if (!warm) perfstart(&perf);
+    opstats_t before, after; // live, while the others go on
+    statsread(stats,&before);
+    
+    int op, j;
+    long *bkeys = (long*)malloc(batch*sizeof(long)); // sorted batch
+    int *bres = (int*)malloc(batch*sizeof(int));
+    for (i=0; duration>0.0 || i<n; i++) {
+      if (duration>0.0 && ++tick%TICKS==0 && (now = omp_get_wtime())>=next) {
+        // end of an interval; the warm-up ends with the first one after it
+        if (ns<maxsamples) {
+          tsamples[ns].phase = !warm;
+          tsamples[ns].time = now-begin;
+          tsamples[ns].span = (ns>0) ? now-begin-tsamples[ns-1].time : now-begin;
+          sample(&tsamples[ns],&last,ops,&list,stats);
+          ns++;
+        }
+        next += interval;
+        if (warm && now-begin>=warmup) {
+          warm = 0;
+          resetcounters(&list);
+          memset(&last,0,sizeof(last));
+          ops = 0;
+          scans = 0;
+          skeys = 0;
+          latinit(tlat);
+          statsread(stats,&before);
+          start = now;
+          perfstart(&perf);
+        }
+        if (now-begin>=warmup+duration) break;
+      }
+      key = genkey(&gen);
+      op = genint(&gen,100);
+      if (batch>1 && (op<pa+pr || op>=pa+pr+pu+ps)) {
+	bkeys[0] = key;
+	for (j=1; j<batch; j++) {
+	  bkeys[j] = genkey(&gen);
+	}
+	qsort(bkeys,batch,sizeof(long),keycmp);
+	if (op<pa) {
+	  TIMED(tlat,LAT_ADD,(add_batch(bkeys,batch,bres,&list),0));
+	} else if (op<pa+pr) {
+	  TIMED(tlat,LAT_REM,(rem_batch(bkeys,batch,bres,&list),0));
+	} else {
+	  TIMED(tlat,LAT_CON,(con_batch(bkeys,batch,bres,&list),0));
+	}
+	ops += batch;
+	i += batch-1;
+#ifdef POLICY
+      } else if (strs!=NULL) {
+	if (op<pa) TIMED(tlat,LAT_ADD,addstr(STR(key),&list));
+	else if (op<pa+pr) TIMED(tlat,LAT_REM,remstr(STR(key),&list));
+	else TIMED(tlat,LAT_CON,constr(STR(key),&list));
+	INC(ops);
+#endif
+      } else if (op<pa) {
+	TIMED(tlat,LAT_ADD,add(key,&list)); INC(ops);
+      } else if (op<pa+pr) {
+	TIMED(tlat,LAT_REM,rem(key,&list)); INC(ops);
+#ifdef MAP
+      } else if (op<pa+pr+pu) {
+	long old;
+	replace(key,i,&old,&list); INC(ops);
+#endif
+#ifndef SPLITORDER
+      } else if (op>=pa+pr+pu && op<pa+pr+pu+ps) {
+	skeys += rangecount(key,key+sl-1,&list); INC(scans); INC(ops);
+#endif
+      } else {
+	TIMED(tlat,LAT_CON,con(key,&list)); INC(ops);
+      }
+    }
+    
+    perfstop(&perf);
+    stop = omp_get_wtime();
+    free(bkeys);
+    free(bres);
+    samples[t] = tsamples;
+    nsamples[t] = ns;
+#pragma omp barrier
+    if (time<stop-start) time = stop-start;
+
+#pragma omp master
+    memusage(&rss,&peak);
+
+    // size from the sharded counters, against a traversal of the list
+#ifndef PRIVATE
+#pragma omp master
+#endif
+    {
+      long exact = sizeexact(stats);
+#ifndef SPLITORDER
+#ifdef POLICY
+      if (strs==NULL)
+#endif
+        TEST(exact==rangecount(LONG_MIN,LONG_MAX,&list));
+#endif
+      statsread(stats,&after);
+      items += exact;
+      sadds += after.adds-before.adds;
+      srems += after.rems-before.rems;
+    }
+#ifndef PRIVATE
+#pragma omp barrier
+#endif
+
+    tops += ops;
+    
+    adds += list.adds;
+    rems += list.rems;
+    cons += list.cons;
+    trav += list.trav;
+    fail += list.fail;
+    rtry += list.rtry;
+    upds += list.upds;
+    pubs += list.pubs;
+    hits += list.hits;
+    elim += list.elim;
+    for (e=0; e<PERFEVENTS; e++) {
+      hw[e] += perf.count[e];
+      nohw[e] |= perf.fd[e]<0;
+    }
+    perfclose(&perf);
+#pragma omp critical
+    latmerge(lat,tlat);
+    free(tlat);
+    if (verbose) {
+      printf("STEADY Thread %d: ops %llu adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu upds %llu\n",
+	     t,ops,list.adds,list.rems,list.cons,list.trav,list.fail,list.rtry,list.upds);
+    }
+
+    clean(&list); // releases the nodes of all threads after the barrier
+#ifdef PRIVATE
+    destroy(&head,&tail);
+    statsdestroy(stats);
+#endif
+  }
+#ifndef PRIVATE
+  destroy(&head,&tail);
+  statsdestroy(stats);
+  free(pkeys);
+#endif
+
+  char benchmark[64];
+  variant(benchmark);
+  if (series!=NULL) seriescsv(samples,nsamples,p,benchmark);
+  for (th=0; th<p; th++) free(samples[th]);
+  free(samples);
+  free(nsamples);
+#ifdef NOBASELINE
+  double base = NAN, speedup = NAN;
+#else
+  double base = baseline2(tops/p,p,f,U,pa,pr,pu,ps,sl,batch,wl,seed); // sequential, ops/s
+  double speedup = ((double)tops/time)/base;
+#endif
+  char basebuf[32], spbuf[32], effbuf[32];
+  if (result!=NULL) { // no output
+    result->metric[0] = ((double)tops/time)/KOPS;
+    result->metric[1] = (double)(trav+cons)/tops;
+    result->metric[2] = (double)(fail+rtry)/tops;
+    result->metric[3] = items;
+    result->metric[4] = rss;
+    result->metric[5] = speedup;
+    result->metric[6] = speedup/p;
+    free(lat);
+    return;
+  }
+
+  printf("STEADY Threads: %d\n",p);
+  if (batch>1) printf("Batch size: %d\n",batch);
+  char keys[64];
+  workloadname(wl,keys,sizeof(keys));
+  if (wl->dist!=DIST_UNIFORM) printf("Keys: %s\n",keys);
+  if (duration>0.0) printf("Duration: %.1f s after %.1f s warm-up, sampled every %.0f ms\n",duration,warmup,interval*MILLI);
+  if (backoffpolicy!=BACKOFF_NONE)
+    printf("Backoff: %s, %u to %u pauses\n",backoffnames[backoffpolicy],backoffmin,backoffmax);
+  printf("Size %ld, adds/s %.0f, rems/s %.0f (sharded counters)\n",items,sadds/time,srems/time);
+  if (pubs>0) printf("Combined: %llu published, hit rate %.2f, %llu eliminated\n",pubs,(double)hits/pubs,elim);
+  if (latex) {
+    printf("Time (ms) & Total ops & Throughput (Kops/s) & Speedup & Efficiency & Build (ms) & RSS (MB) & Peak RSS (MB) & adds & rems & cons& trav & fail & rtry & upds & scans & Scan throughput (Kkeys/s) \\\\\n");
+    printf("%.2f & %llu & %.2f & %s & %s & %.2f & %.1f & %.1f & %llu & %llu & %llu & %llu & %llu & %llu & %llu & %llu & %.2f \\\\\n",
+	   time*MILLI,tops,((double)tops/time)/KOPS,ratio(spbuf,speedup,"n/a"),ratio(effbuf,speedup/p,"n/a"),btime*MILLI,rss,peak,
+	   adds,rems,cons,trav,fail,rtry,upds,scans,((double)skeys/time)/KOPS);
+    latprint(lat,latex);
+  } else if (csv) {
+    printf("Time (ms);Total ops;Throughput (Kops/s);Build (ms);RSS (MB);Peak RSS (MB);adds;rems;cons;trav;fail;rtry;upds;published;combiner hit rate;eliminated;scans;scanned keys;Scan throughput (Kkeys/s);hops/op;L1 misses/op;LLC misses/op;");
+    perfcsv(hw,nohw,tops,trav+cons,1);
+    printf("size;");
+    latcsv(lat,1);
+    printf("batch;regions;keys;duration (s);warm-up (s);backoff;backoff min;backoff max;");
+    placecsv(1);
+    printf("baseline (Kops/s);speedup;efficiency;threads;benchmark\n");
+    printf("%.2f;%llu;%.2f;%.2f;%.1f;%.1f;%llu;%llu;%llu;%llu;%llu;%llu;%llu;%llu;%.2f;%llu;%llu;%llu;%.2f;%.2f;%s;%s;",
+      time*MILLI, tops, ((double)tops/time)/KOPS, btime*MILLI, rss, peak, adds, rems, cons, trav, fail, rtry, upds,
+      pubs, (pubs>0) ? (double)hits/pubs : 0.0, elim,
+      scans, skeys, ((double)skeys/time)/KOPS,
+      (double)(trav+cons)/tops, perop(l1buf,hw[PERF_L1MISS],tops,!nohw[PERF_L1MISS],"NA"), perop(llcbuf,hw[PERF_LLCMISS],tops,!nohw[PERF_LLCMISS],"NA"));
+    perfcsv(hw,nohw,tops,trav+cons,0);
+    printf("%ld;",items);
+    latcsv(lat,0);
+    printf("%d;%ld;%s;%.1f;%.1f;%s;%u;%u;",batch,wl->hot,keys,duration,warmup,backoffnames[backoffpolicy],backoffmin,backoffmax);
+    placecsv(0);
+    printf("%s;%s;%s;%d;%s\n",ratio(basebuf,base/KOPS,"NA"),ratio(spbuf,speedup,"NA"),ratio(effbuf,speedup/p,"NA"),p,benchmark);
+  } else {
+    printf("Time (ms) %.2f Total ops %llu Throughput (Kops/s) %.2f\n",
+	   time*MILLI,tops,((double)tops/time)/KOPS);
+    printf("Sequential (Kops/s) %s Speedup %s Efficiency %s\n",
+	   ratio(basebuf,base/KOPS,"n/a"),ratio(spbuf,speedup,"n/a"),ratio(effbuf,speedup/p,"n/a"));
+    printf("Build (ms) %.2f RSS (MB) %.1f Peak RSS (MB) %.1f\n",btime*MILLI,rss,peak);
+    printf("adds %llu rems %llu cons %llu trav %llu fail %llu rtry %llu upds %llu\n",
+	   adds,rems,cons,trav,fail,rtry,upds);
+    printf("scans %llu keys %llu Scan throughput (Kkeys/s) %.2f\n",
+	   scans,skeys,((double)skeys/time)/KOPS);
+    printf("hops/op %.2f L1 misses/op %s LLC misses/op %s\n",
+	   (double)(trav+cons)/tops,
+	   perop(l1buf,hw[PERF_L1MISS],tops,!nohw[PERF_L1MISS],"n/a"),
+	   perop(llcbuf,hw[PERF_LLCMISS],tops,!nohw[PERF_LLCMISS],"n/a"));
+    perfprint(hw,nohw,tops,trav+cons);
+    latprint(lat,latex);
+  }
+  free(lat);
+}
+
+// stress (-B H): adds, removes and lookups with heavy overlap on a small
+// key range, each logged with the time of its invocation and response, and
+// the history checked for linearizability; 1 if it is not linearizable
+int benchmark3(int n, int p, int f, int U, int pa, int pr, const workload_t *wl, unsigned seed,
+               const char *file, int csv)
+{
+#ifdef PRIVATE
+  (void)n; (void)p; (void)f; (void)U; (void)pa; (void)pr; (void)wl; (void)seed; (void)file; (void)csv;
+  printf("No history of private lists\n");
+  return 0;
+#else
+  history_t hist; // of all threads
+  verdict_t verdict;
+  double time = 0.0, check;
+
+  histinit(&hist,0);
+  node_t head, tail;
+  create(&head,&tail);
+  stats_t *stats = statscreate();
+  long *pkeys = (long*)malloc(f*sizeof(long)); // prefill
+  int pf = 0;
+
+#pragma omp parallel shared(head) shared(tail) reduction(max:time)
+  {
+    double start, stop;
+    list_t list;
+    history_t thist;
+    unsigned long long invoke;
+    long i, key;
+    int op, res;
+
+    int t = omp_get_thread_num();
+
+    pin(t);
+    gen_t gen;
+    genseed(&gen,wl,seed,t,p);
+    init(&head,&tail,&list);
+    attach(stats,&list);
+    histinit(&thist,n);
+
+#pragma omp single
+    {
+      int u;
+      for (u=0; u<U && pf<f; u++) {
+        if (genrand(&gen)%(U-u)<(unsigned)(f-pf)) pkeys[pf++] = u;
+      }
+      histstart(&hist,pkeys,pf);
+    }
+#ifdef POLICY
+    if (strs!=NULL) {
+#pragma omp for schedule(static)
+      for (i=0; i<pf; i++)
+        addstr(STR(pkeys[i]),&list);
+    } else
+#endif
+    load(pkeys,pf,1,&list);
+
+#pragma omp barrier
+    start = omp_get_wtime();
+    for (i=0; i<n; i++) {
+      key = genkey(&gen);
+      op = genint(&gen,100);
+      op = (op<pa) ? HIST_ADD : (op<pa+pr) ? HIST_REM : HIST_CON;
+      invoke = histnow();
+#ifdef POLICY
+      if (strs!=NULL)
+        res = (op==HIST_ADD) ? addstr(STR(key),&list) : (op==HIST_REM) ? remstr(STR(key),&list) : constr(STR(key),&list);
+      else
+#endif
+      res = (op==HIST_ADD) ? add(key,&list) : (op==HIST_REM) ? rem(key,&list) : con(key,&list);
+      histlog(&thist,op,key,res,t,invoke,histnow());
+    }
+    stop = omp_get_wtime();
+    if (time<stop-start) time = stop-start;
+
+#pragma omp barrier
+#pragma omp critical
+    histappend(&hist,&thist);
+    histfree(&thist);
+    clean(&list);
+  }
+  destroy(&head,&tail);
+  statsdestroy(stats);
+  free(pkeys);
+
+  if (file!=NULL) {
+    FILE *out = fopen(file,"w");
+    if (out==NULL || !histwrite(&hist,out)) fprintf(stderr,"Cannot write %s\n",file);
+    if (out!=NULL) fclose(out);
+  }
+  check = omp_get_wtime();
+  histcheck(&hist,&verdict,stdout);
+  check = omp_get_wtime()-check;
+  histfree(&hist);
+
+  char benchmark[64];
+  variant(benchmark);
+  if (csv) {
+    printf("Time (ms);operations;keys;not linearizable;unknown;Check (ms);threads;benchmark\n");
+    printf("%.2f;%ld;%ld;%ld;%ld;%.2f;%d;%s\n",time*MILLI,verdict.ops,verdict.keys,verdict.violations,verdict.unknown,check*MILLI,p,benchmark);
+  } else {
+    printf("HISTORY Threads: %d\n",p);
+    printf("Time (ms) %.2f operations %ld keys %ld\n",time*MILLI,verdict.ops,verdict.keys);
+    printf("not linearizable %ld unknown %ld Check (ms) %.2f\n",verdict.violations,verdict.unknown,check*MILLI);
+  }
+
+  return verdict.violations>0;
+#endif
+}
+
+// the mix, distribution and key range of a run; -1 for an unknown mix
+int configure(workload_t *wl, int dist, const char *mix, int U, int *pa, int *pr, int *pu, int *ps)
+{
+  int d;
+
+  if (mix!=NULL) {
+#ifdef MAP
+    d = workloadmix(mix,1,pa,pr,pu,ps);
+#else
+    d = workloadmix(mix,0,pa,pr,pu,ps);
+#endif
+    if (d<0) return -1;
+    if (dist<0) dist = d;
+  }
+  if (dist<0) dist = (wl->hot>0) ? DIST_REGIONS : DIST_UNIFORM;
+  wl->dist = dist;
+  if (wl->dist!=DIST_REGIONS) wl->hot = 0;
+  if (wl->window<1) wl->window = (U/100>0) ? U/100 : 1;
+  workloadinit(wl,U);
+  return 0;
+}
+
+// sweep (-N, lists for -p, -f, -U and -Y): every combination reps times on
+// fresh lists, summarized as mean, standard deviation and 95% confidence
+#define SWEEPMAX 64
+
+typedef struct _sweep {
+  int threads[SWEEPMAX], nthreads;
+  int prefill[SWEEPMAX], nprefill;
+  int range[SWEEPMAX], nrange; // -1 for 10*prefill
+  char *mix[SWEEPMAX]; int nmix; // NULL for -A -R -W -Q
+  int reps;
+  int json;
+  int rows; // printed so far
+} sweep_t;
+
+// values like 1,2,4,8; their number, 0 if malformed
+int sweeplist(char *arg, int values[])
+{
+  char *s, *end;
+  int n = 0;
+
+  for (s = arg; n<SWEEPMAX; s = end+1) {
+    values[n++] = (int)strtol(s,&end,10);
+    if (end==s) return 0;
+    if (*end!=',') break;
+  }
+  return n;
+}
+
+// two-sided Student t for 95% confidence
+double student(int df)
+{
+  static const double t[] = {12.706,4.303,3.182,2.776,2.571,2.447,2.365,2.306,2.262,2.228,
+                             2.201,2.179,2.160,2.145,2.131,2.120,2.110,2.101,2.093,2.086,
+                             2.080,2.074,2.069,2.064,2.060,2.056,2.052,2.048,2.045,2.042};
+
+  if (df<1) return 0.0;
+  if (df<=30) return t[df-1];
+  return 1.96;
+}
+
+void sweepprint(sweep_t *sw, result_t res[], int t, int f, int U, const char *mix, const int pct[4], const workload_t *wl, int c)
+{
+  char name[64], keys[64];
+  double mean[METRICS], sd[METRICS], ci[METRICS];
+  int m, r, n = sw->reps;
+
+  variant(name);
+  workloadname(wl,keys,sizeof(keys));
+  for (m=0; m<METRICS; m++) {
+    mean[m] = 0.0;
+    for (r=0; r<n; r++) mean[m] += res[r].metric[m];
+    mean[m] /= n;
+    sd[m] = 0.0;
+    for (r=0; r<n; r++) sd[m] += (res[r].metric[m]-mean[m])*(res[r].metric[m]-mean[m]);
+    sd[m] = (n>1) ? sqrt(sd[m]/(n-1)) : 0.0;
+    ci[m] = student(n-1)*sd[m]/sqrt(n);
+  }
+
+  if (sw->json) {
+    printf("%s  {\"benchmark\": \"%s\", \"threads\": %d, \"prefill\": %d, \"range\": %d, \"mix\": \"%s\", \"adds\": %d, \"rems\": %d, \"updates\": %d, \"scans\": %d, \"keys\": \"%s\", \"ops\": %d, \"duration\": %.1f, \"reps\": %d",
+           (sw->rows==0) ? "[\n" : ",\n",name,t,f,U,(mix!=NULL) ? mix : "-",pct[0],pct[1],pct[2],pct[3],keys,c,duration,n);
+    for (m=0; m<METRICS; m++) {
+      if (isnan(mean[m])) printf(", \"%s\": null",metrickeys[m]); // no baseline
+      else printf(", \"%s\": {\"mean\": %g, \"sd\": %g, \"ci95\": %g}",metrickeys[m],mean[m],sd[m],ci[m]);
+    }
+    printf("}");
+  } else {
+    if (sw->rows==0) {
+      printf("prefill;range;mix;adds (%%);rems (%%);updates (%%);scans (%%);keys;ops;duration (s);reps;");
+      for (m=0; m<METRICS; m++) printf("%s mean;%s sd;%s ci95;",metricnames[m],metricnames[m],metricnames[m]);
+      printf("threads;benchmark\n");
+    }
+    printf("%d;%d;%s;%d;%d;%d;%d;%s;%d;%.1f;%d;",f,U,(mix!=NULL) ? mix : "-",pct[0],pct[1],pct[2],pct[3],keys,c,duration,n);
+    for (m=0; m<METRICS; m++) {
+      if (isnan(mean[m])) printf("NA;NA;NA;"); // no baseline
+      else printf("%.3f;%.3f;%.3f;",mean[m],sd[m],ci[m]);
+    }
+    printf("%d;%s\n",t,name);
+  }
+  fflush(stdout);
+  sw->rows++;
+}
+
+void sweep(sweep_t *sw, int c, int pa, int pr, int pu, int ps, int sl, int batch,
+           const workload_t *base, int dist, unsigned seed)
+{
+  result_t *res = (result_t*)malloc(sw->reps*sizeof(result_t));
+  workload_t wl;
+  int x, y, z, w, r, U;
+  int pct[4]; // adds, removes, updates and scans
+
+  for (x=0; x<sw->nmix; x++) {
+    for (y=0; y<sw->nprefill; y++) {
+      for (z=0; z<sw->nrange; z++) {
+        U = (sw->range[z]>0) ? sw->range[z] : 10*sw->prefill[y];
+        pct[0] = pa; pct[1] = pr; pct[2] = pu; pct[3] = ps;
+        wl = *base;
+        configure(&wl,dist,sw->mix[x],U,&pct[0],&pct[1],&pct[2],&pct[3]);
+        for (w=0; w<sw->nthreads; w++) {
+          omp_set_num_threads(sw->threads[w]);
+          for (r=0; r<sw->reps; r++)
+            benchmark2(c,sw->threads[w],sw->prefill[y],U,pct[0],pct[1],pct[2],pct[3],sl,batch,&wl,seed+r,0,0,0,&res[r]);
+          sweepprint(sw,res,sw->threads[w],sw->prefill[y],U,sw->mix[x],pct,&wl,c);
+        }
+      }
+    }
+  }
+  free(res);
+}
+
+int main(int argc, char *argv[])
+{
+  int i, j;
+
+  int p; // number of threads
+  
+  int n, f, c;
+  int ar, ao, rr, ro; // add and remove factors and offsets
+  int pa, pr, pu, ps; // percentage (integer) of adds, removes, value updates (MAP) and range scans
+  int sl; // keys per range scan
+  int batch; // keys per add, rem and con
+  workload_t wl; // distribution of the keys
+  int dist;
+  sweep_t sw;
+  int verbose, latex, csv;
+  const char *history = NULL; // written by -B H
+  int violations = 0;
+
+  int U;
+  unsigned seed;
+  char benchmark = '_'; // _ = both; D = deterministic; S = steady
+#ifdef POLICY
+  char *names = "all"; // variants to run
+  int styles = 1<<STR_NONE; // keys to run them with
+#endif
+  
+  n = N;
+  f = N;
+  c = N;
+  
+  p = -1;
+
+  ar = -1;
+  ao = -1;
+  rr = -1;
+  ro = -1;
+
+  U = -1;
+  pa = 10; pr = 10; pu = 0; ps = 0; // 10% add, 10% rem
+  sl = 100;
+  batch = 1;
+  memset(&wl,0,sizeof(wl));
+  wl.hot = 0; wl.width = 64;  // hot regions of keys, 0 for uniform keys
+  wl.theta = 0.99;            // zipf
+  wl.hotops = 80; wl.hotkeys = 20; // hotspot
+  wl.window = 0; wl.period = 100;  // shift, U/100 keys by default
+  dist = -1;
+  memset(&sw,0,sizeof(sw));
+  sw.mix[0] = NULL;
+  
+  verbose = 0;
+  latex = 0;
+  csv=0;
+  
+  for (i=1; i<argc&&argv[i][0]=='-'; i++) {
+    if (argv[i][1]=='h') {
+      printf("Quadratic benchmark:\n");
+      printf("-n\tNumber of elements\n");
+      printf("Randomized throughput benchmark:\n");
+      printf("-c\tNumber of operations\n");
+    }
+    if (argv[i][1]=='n') i++,sscanf(argv[i],"%d",&n); // number elements (deterministic benchmark)
+    if (argv[i][1]=='p') i++,sw.nthreads = sweeplist(argv[i],sw.threads); // number threads, or a list
+
+    if (argv[i][1]=='r') i++,sscanf(argv[i],"%d",&ar); // add factor
+    if (argv[i][1]=='o') i++,sscanf(argv[i],"%d",&ao); // add offset
+    if (argv[i][1]=='R') i++,sscanf(argv[i],"%d",&rr); // remove factor
+    if (argv[i][1]=='O') i++,sscanf(argv[i],"%d",&ro); // remove offset
+
+    if (argv[i][1]=='c') i++,sscanf(argv[i],"%d",&c); // number operations (randomized benchmark)
+    if (argv[i][1]=='f') i++,sw.nprefill = sweeplist(argv[i],sw.prefill); // prefill
+    if (argv[i][1]=='U') i++,sw.nrange = sweeplist(argv[i],sw.range); // key-range (default 10*prefill)
+    if (argv[i][1]=='A') i++,sscanf(argv[i],"%d",&pa);
+    if (argv[i][1]=='R') i++,sscanf(argv[i],"%d",&pr);
+    if (argv[i][1]=='W') i++,sscanf(argv[i],"%d",&pu); // value updates of present keys (MAP)
+    if (argv[i][1]=='Q') i++,sscanf(argv[i],"%d",&ps); // range scans
+    if (argv[i][1]=='l') i++,sscanf(argv[i],"%d",&sl); // range of keys per scan
+    if (argv[i][1]=='b') i++,sscanf(argv[i],"%d",&batch); // sorted batches of keys
+    if (argv[i][1]=='H') i++,sscanf(argv[i],"%ld",&wl.hot); // hot regions
+    if (argv[i][1]=='w') i++,sscanf(argv[i],"%ld",&wl.width); // keys per hot region
+    if (argv[i][1]=='D') { // key distribution
+      i++;
+      if (!workloadparse(&wl,argv[i])) {
+        fprintf(stderr,"Unknown distribution %s, one of uniform zipf[:theta] hotspot[:ops,keys] shift[:window,period] asc desc\n",argv[i]);
+        return 1;
+      }
+      dist = wl.dist;
+      continue;
+    }
+    if (argv[i][1]=='Y') { // YCSB-like mixes, comma separated
+      char *m;
+      i++;
+      sw.nmix = 0;
+      for (m = strtok(argv[i],","); m!=NULL && sw.nmix<SWEEPMAX; m = strtok(NULL,","))
+        sw.mix[sw.nmix++] = m;
+      continue;
+    }
+    if (argv[i][1]=='N') i++,sscanf(argv[i],"%d",&sw.reps); // repetitions of a sweep
+    if (argv[i][1]=='j') sw.json = 1;
+    if (argv[i][1]=='y') { // history of -B H
+      i++,history = argv[i];
+      continue;
+    }
+    if (argv[i][1]=='d') i++,sscanf(argv[i],"%lf",&duration); // seconds instead of -c operations
+    if (argv[i][1]=='e') i++,sscanf(argv[i],"%lf",&warmup);   // seconds before the timed region
+    if (argv[i][1]=='i') { // sampling interval in ms
+      double ms;
+      i++;
+      if (sscanf(argv[i],"%lf",&ms)==1) interval = ms/MILLI;
+    }
+    if (argv[i][1]=='z') { // time series, appended
+      i++;
+      series = fopen(argv[i],"a");
+      if (series==NULL) {
+        fprintf(stderr,"Cannot open %s\n",argv[i]);
+        return 1;
+      }
+      if (ftell(series)==0)
+        fprintf(series,"interval;time (s);phase;span (s);ops;Throughput (Kops/s);adds;rems;cons;trav;fail;rtry;hops/op;size;RSS (MB);thread;threads;benchmark\n");
+      continue;
+    }
+
+    if (argv[i][1]=='S') i++,sscanf(argv[i],"%d",&seed);
+    if (argv[i][1]=='M') { // placement of node memory
+      i++;
+      for (j=0; slabnames[j]!=NULL&&strncmp(argv[i],slabnames[j],strlen(slabnames[j]))!=0; j++);
+      if (slabnames[j]==NULL) {
+        fprintf(stderr,"Unknown memory placement %s, one of default local interleave bind:<node>\n",argv[i]);
+        return 1;
+      }
+      slabpolicy = j;
+      if (j==SLAB_BIND && argv[i][4]==':') sscanf(argv[i]+5,"%d",&slabnode);
+      continue; // the name is no flag
+    }
+    if (argv[i][1]=='a') { // thread pinning
+      i++;
+      if (strcmp(argv[i],"compact")==0) pinpolicy = PIN_COMPACT;
+      else if (strcmp(argv[i],"scatter")==0) pinpolicy = PIN_SCATTER;
+      else if (strcmp(argv[i],"none")==0) pinpolicy = PIN_NONE;
+      else if (!pinlist(argv[i])) {
+        fprintf(stderr,"Unknown pinning %s, none, compact, scatter or CPUs like 0-3,8\n",argv[i]);
+        return 1;
+      }
+      continue;
+    }
+    if (argv[i][1]=='X') { // backoff strategy
+      i++;
+      for (j=0; backoffnames[j]!=NULL&&strcmp(argv[i],backoffnames[j])!=0; j++);
+      if (backoffnames[j]==NULL) {
+        fprintf(stderr,"Unknown backoff %s, one of",argv[i]);
+        for (j=0; backoffnames[j]!=NULL; j++) fprintf(stderr," %s",backoffnames[j]);
+        fprintf(stderr,"\n");
+        return 1;
+      }
+      backoffpolicy = j;
+      continue; // the name is no flag
+    }
+    if (argv[i][1]=='x') i++,sscanf(argv[i],"%u,%u",&backoffmin,&backoffmax); // pauses
+    if (argv[i][1]=='T') i++,sscanf(argv[i],"%d",&latperiod); // time one in that many operations
+    if (argv[i][1]=='V') verbose = 1;
+    if (argv[i][1]=='L') latex = 1;
+    if (argv[i][1]=='C') csv = 1;
+#ifdef POLICY
+    if (argv[i][1]=='P') i++,names = argv[i];
+    if (argv[i][1]=='K') { // string keys, strcmp, prefix or both
+      i++;
+      if (argv[i][0]=='s') styles = 1<<STR_PLAIN;
+      if (argv[i][0]=='p') styles = 1<<STR_PREFIX;
+      if (argv[i][0]=='b') styles = 1<<STR_PLAIN|1<<STR_PREFIX;
+    }
+#endif
+
+    if (argv[i][1]=='B') {
+       i++;
+      benchmark = argv[i][0];
+      if (benchmark != 'D' && benchmark != 'S' && benchmark != 'H')
+        benchmark = '_';
+    }
+  }
+
+#ifndef MAP
+  if (pu>0) { // no values to update
+    fprintf(stderr,"No value updates without MAP, -W %d ignored\n",pu);
+    pu = 0;
+  }
+#endif
+
+  // a single run, or a sweep
+  if (sw.nthreads>0) p = sw.threads[0];
+  if (sw.nprefill>0) f = sw.prefill[0];
+  else sw.prefill[sw.nprefill++] = f;
+  if (sw.nrange>0) U = sw.range[0];
+  else sw.range[sw.nrange++] = U;
+  if (sw.nmix==0) sw.nmix = 1;
+  if (benchmark!='H' && (sw.reps>0 || sw.nthreads>1 || sw.nprefill>1 || sw.nrange>1 || sw.nmix>1)) {
+    if (sw.reps<1) sw.reps = 1;
+    benchmark = 'S';
+    csv = !sw.json;
+    latex = 0;
+    verbose = 0;
+  }
+  if (sw.nthreads==0) sw.threads[sw.nthreads++] = p;
+  for (i=0; i<sw.nthreads; i++)
+    if (sw.threads[i]<=0) sw.threads[i] = omp_get_max_threads();
+  if (p<=0) p = omp_get_max_threads(); // default
+  else omp_set_num_threads(p);
+
+  if (ar==-1) ar = p;
+  if (ao==-1) ao = 0;
+  if (rr==-1) rr = p;
+  if (ro==-1) ro = 0;
+  if (U==-1) U = 10*f;
+  if (batch<1) batch = 1;
+  if (duration<0.0) duration = 0.0;
+  if (duration==0.0) warmup = 0.0;
+  if (interval<=0.0) interval = 0.1;
+  assert(pa+pr+pu+ps<=100);
+  for (i=0; i<sw.nmix; i++) {
+    int a = pa, d = pr, u = pu, q = ps;
+    workload_t check = wl;
+    if (configure(&check,dist,sw.mix[i],U,&a,&d,&u,&q)<0) {
+      fprintf(stderr,"Unknown mix %s, one of a b c d e f\n",sw.mix[i]);
+      return 1;
+    }
+  }
+  workload_t base = wl; // for the sweep
+  configure(&wl,dist,sw.mix[0],U,&pa,&pr,&pu,&ps);
+  if (backoffmax<backoffmin) backoffmax = backoffmin;
+  if (latperiod<0) latperiod = 0;
+  if (latperiod>0) latcalibrate();
+  if (pinpolicy==PIN_COMPACT || pinpolicy==PIN_SCATTER) sockets = pinorder(pinpolicy);
+  else sockets = pinsockets();
+  if (slabpolicy!=SLAB_DEFAULT && !slabnuma()) {
+    fprintf(stderr,"No NUMA placement of %s, first touch instead\n",slabnames[slabpolicy]);
+    slabpolicy = SLAB_DEFAULT;
+  }
+  if (!latex && !csv && !sw.json) placeprint();
+#ifdef POLICY
+  if (backoffpolicy!=BACKOFF_NONE) {
+    fprintf(stderr,"The policy variants retry immediately\n");
+    return 1;
+  }
+#endif
+
+#ifdef POLICY
+  if (styles!=1<<STR_NONE) {
+    // only the steady benchmark, without batches and scans
+    unsigned long u;
+    for (i=0; i<sw.nrange; i++) // of all the sweep
+      if (sw.range[i]>U) U = sw.range[i];
+    for (i=0; i<sw.nprefill; i++)
+      if (sw.range[0]<0 && 10*sw.prefill[i]>U) U = 10*sw.prefill[i];
+    strs = (char*)malloc((size_t)U*STRLEN);
+    for (u=0; u<(unsigned long)U; u++)
+      sprintf(STR(u),"%016lx",u*0x9E3779B97F4A7C15UL);
+    if (benchmark!='H') benchmark = 'S';
+    batch = 1;
+    ps = 0;
+  }
+
+  // the selected variants, one after the other
+  int v, found = 0;
+  for (v = 0; policies[v] != NULL; v++) {
+    if (!listed(policies[v],names)) continue;
+    policy(policies[v]);
+    found = 1;
+    for (strstyle = STR_NONE; strstyle <= STR_PREFIX; strstyle++) {
+    if (!(styles&1<<strstyle)) continue;
+    strkeys(strstyle);
+    if (!latex && !csv && !sw.json) {
+      char name[64];
+      variant(name);
+      printf("Variant: %s\n",name);
+    }
+#endif
+  if (benchmark == 'D' || benchmark == '_')
+    benchmark1(n,p,ar,ao,rr,ro,verbose,latex,csv);
+
+  if (benchmark == 'H')
+    violations += benchmark3(c,p,f,U,pa,pr,&wl,seed,history,csv);
+  else if (sw.reps>0)
+    sweep(&sw,c,pa,pr,pu,ps,sl,batch,&base,dist,seed);
+  else if (benchmark == 'S' || benchmark == '_')
+    benchmark2(c,p,f,U,pa,pr,pu,ps,sl,batch,&wl,seed,verbose,latex,csv,NULL);
+#ifdef POLICY
+    }
+  }
+  free(strs);
+  if (!found) {
+    fprintf(stderr,"Unknown variant %s, one of all",names);
+    for (v = 0; policies[v] != NULL; v++) fprintf(stderr," %s",policies[v]);
+    fprintf(stderr,"\n");
+    return 1;
+  }
+#endif
+  
+  if (sw.json && sw.rows>0) printf("\n]\n");
+  if (series!=NULL) fclose(series);
+  return violations>0;
+}
@@ -0,0 +1,529 @@
+/* Improved lock-free linked list implementations */
+/* Header-only, policy-based C++ (C++17) version of linkedlist.c */
+
+// LockFreeList<Policies...> generates the variants of the #ifdef matrix of
+// linkedlist.c from compile-time policies, with the same traversal, marking
+// and retry code. Policies can be given in any order; omitted ones default:
+//
+// traversal start: FromHead   - textbook, every traversal and retry from head
+//                  FromPred   - retry from the pred of the operation (default)
+//                  FromCursor - as FromPred, and keep the cursor between operations
+// backward links:  Singly (default), Doubly - approximate prev pointers
+// delete mark:     CasMark    - textbook, one CAS from the unmarked successor
+//                  CasLoopMark - CAS until marked, or found marked (default)
+//                  FetchOrMark - one fetch_or
+// memory order:    AcqRel (default), SeqCst
+// keys:            LongKeys   - long, LONG_MIN and LONG_MAX sentinels (default)
+//                  Keys<T,Less> - any key with a comparator, explicit sentinels
+//                  StringKeys - C strings, compared with strcmp
+//                  PrefixKeys - C strings with an inline prefix
+// node and list:   Types<Node,List> (default Types<lockfree::Node,lockfree::List>,
+//                  Types<BasicNode<T>,BasicList<BasicNode<T>>> for other keys)
+//
+// The operations are static and take the per thread List, as in linkedlist.h:
+//
+//   using L = lockfree::LockFreeList<lockfree::FromCursor,lockfree::Doubly>;
+//   L::create(&head,&tail);     // once
+//   L::init(&head,&tail,&list); // per thread
+//   L::add(key,&list); ...
+//   L::clean(&list);            // at quiescence
+
+#ifndef LOCKFREELIST_HPP
+#define LOCKFREELIST_HPP
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <cassert>
+#include <new>
+#include <type_traits>
+
+#include "slab.h"
+
+namespace lockfree {
+
+// policy categories
+struct StartPolicy {};
+struct LinksPolicy {};
+struct MarkPolicy {};
+struct OrderPolicy {};
+struct KeyPolicy {};
+struct TypesPolicy {};
+
+struct FromHead : StartPolicy {
+  static constexpr bool head = true, cursor = false;
+};
+struct FromPred : StartPolicy {
+  static constexpr bool head = false, cursor = false;
+};
+struct FromCursor : StartPolicy {
+  static constexpr bool head = false, cursor = true;
+};
+
+struct Singly : LinksPolicy {
+  static constexpr bool doubly = false;
+};
+struct Doubly : LinksPolicy {
+  static constexpr bool doubly = true;
+};
+
+struct CasMark : MarkPolicy {
+  static constexpr bool textbook = true, fetch = false;
+};
+struct CasLoopMark : MarkPolicy {
+  static constexpr bool textbook = false, fetch = false;
+};
+struct FetchOrMark : MarkPolicy {
+  // x86 has no atomic fetch-or, it is emulated with a CAS loop
+  static constexpr bool textbook = false, fetch = true;
+};
+
+struct AcqRel : OrderPolicy {
+  static constexpr std::memory_order load = std::memory_order_acquire;
+  static constexpr std::memory_order store = std::memory_order_release;
+  static constexpr std::memory_order rmw = std::memory_order_acq_rel;
+  static constexpr std::memory_order fail = std::memory_order_acquire;
+};
+struct SeqCst : OrderPolicy {
+  static constexpr std::memory_order load = std::memory_order_seq_cst;
+  static constexpr std::memory_order store = std::memory_order_seq_cst;
+  static constexpr std::memory_order rmw = std::memory_order_seq_cst;
+  static constexpr std::memory_order fail = std::memory_order_seq_cst;
+};
+
+// The key of head is below, that of tail above all keys. With sentinels,
+// these are key values, otherwise head and tail are compared by address.
+struct LongKeys : KeyPolicy {
+  using key = long;
+  static constexpr bool sentinels = true;
+  static constexpr long min = LONG_MIN, max = LONG_MAX;
+  static bool less(long a, long b) { return a < b; }
+};
+
+// Less is a strict weak order; keys are copied into the nodes as they are
+template <class T, class Less = std::less<T>>
+struct Keys : KeyPolicy {
+  using key = T;
+  static constexpr bool sentinels = false;
+  static bool less(const T &a, const T &b) { return Less()(a, b); }
+};
+
+// NUL terminated, not copied: must stay valid while in the list
+struct StringLess {
+  bool operator()(const char *a, const char *b) const { return strcmp(a, b) < 0; }
+};
+
+using StringKeys = Keys<const char*, StringLess>;
+
+// A C string with its first 8 bytes inline, as a big-endian word, so that
+// keys with different prefixes are ordered by one integer compare, without
+// touching the strings
+struct PrefixString {
+  uint64_t prefix; // zero padded
+  const char *str;
+
+  PrefixString() = default;
+  PrefixString(const char *s) : prefix(0), str(s)
+  {
+    int i;
+
+    for (i = 0; i < 8 && s[i] != '\0'; i++)
+      prefix |= (uint64_t)(unsigned char)s[i] << (56-8*i);
+  }
+};
+
+struct PrefixLess {
+  bool operator()(const PrefixString &a, const PrefixString &b) const
+  {
+    if (a.prefix != b.prefix)
+      return a.prefix < b.prefix;
+    if ((a.prefix & 0xff) == 0)
+      return false; // equal, both end within the prefix
+    return strcmp(a.str+8, b.str+8) < 0;
+  }
+};
+
+using PrefixKeys = Keys<PrefixString, PrefixLess>;
+
+// the default node (as the default layout of linkedlist.h) and per thread list
+struct Node {
+  std::atomic<Node*> next;
+  std::atomic<Node*> prev;
+  Node *free;
+  char padding[40]; // fill the cacheline
+  long key;
+};
+
+template <class N>
+struct BasicList {
+  N *head, *tail; // sentinels, possibly shared
+  N *curr;        // private cursor (last operation)
+  N *pred;        // predecessor of cursor
+  slab_t slab;    // private node allocation, released in bulk by clean()
+  unsigned long long adds, rems, cons, trav, fail, rtry;
+};
+
+using List = BasicList<Node>;
+
+// unpadded, for other keys
+template <class T>
+struct BasicNode {
+  std::atomic<BasicNode*> next;
+  std::atomic<BasicNode*> prev;
+  BasicNode *free;
+  T key;
+};
+
+// Node needs atomic next and prev and a key; List the members of BasicList
+template <class N, class L>
+struct Types : TypesPolicy {
+  using node = N;
+  using list = L;
+};
+
+// the first of Policies of Category, else Default
+template <class Category, class Default, class... Policies>
+struct select {
+  using type = Default;
+};
+
+template <class Category, class Default, class P, class... Policies>
+struct select<Category, Default, P, Policies...> {
+  using type = std::conditional_t<std::is_base_of_v<Category, P>, P,
+                                  typename select<Category, Default, Policies...>::type>;
+};
+
+template <class K>
+using DefaultTypes = std::conditional_t<std::is_same_v<K, LongKeys>, Types<Node, List>,
+                                        Types<BasicNode<typename K::key>, BasicList<BasicNode<typename K::key>>>>;
+
+template <class... Policies>
+class LockFreeList {
+public:
+  using Start = typename select<StartPolicy, FromPred, Policies...>::type;
+  using Links = typename select<LinksPolicy, Singly, Policies...>::type;
+  using Mark = typename select<MarkPolicy, CasLoopMark, Policies...>::type;
+  using Order = typename select<OrderPolicy, AcqRel, Policies...>::type;
+  using KeyType = typename select<KeyPolicy, LongKeys, Policies...>::type;
+  using Node = typename select<TypesPolicy, DefaultTypes<KeyType>, Policies...>::type::node;
+  using List = typename select<TypesPolicy, DefaultTypes<KeyType>, Policies...>::type::list;
+  using Key = typename KeyType::key;
+  using KeyArg = std::conditional_t<std::is_scalar_v<Key>, Key, const Key&>;
+
+  static_assert(!(Start::head && Links::doubly), "the doubly linked variants start from the backward pointers");
+  static_assert(std::is_trivially_destructible_v<Key>, "nodes are released in bulk");
+
+  // the shared sentinels, once per list
+  static void create(Node *head, Node *tail)
+  {
+    if constexpr (KeyType::sentinels) {
+      head->key = KeyType::min;
+      tail->key = KeyType::max;
+    }
+    head->next = tail;
+    tail->next = nullptr;
+    head->prev = nullptr;
+    tail->prev = head;
+  }
+
+  // per thread
+  static void init(Node *head, Node *tail, List *list)
+  {
+    list->head = head;
+    list->tail = tail;
+
+    list->pred = head;
+    list->curr = nullptr;
+
+    slabinit(&list->slab, sizeof(Node));
+
+    list->adds = 0;
+    list->rems = 0;
+    list->cons = 0;
+    list->trav = 0;
+    list->fail = 0;
+    list->rtry = 0;
+  }
+
+  // at quiescence: releases all nodes allocated by list
+  static void clean(List *list)
+  {
+    slabrelease(&list->slab);
+  }
+
+  // list->pred and list->curr: the last node before key, the first not before
+  static void pos(KeyArg key, List *list)
+  {
+    Node *pred, *succ, *curr, *next;
+
+    if constexpr (Links::doubly) {
+      pred = list->pred;
+      if (!Start::cursor && !below(pred, key, list))
+        pred = list->head;
+    }
+
+  retry:
+    if constexpr (Links::doubly) {
+      while (ismarked(load(pred->next)) || !below(pred, key, list)) {
+        list->trav++;
+        pred = load(pred->prev);
+      }
+    } else if constexpr (Start::head) {
+      pred = list->head;
+    } else {
+      pred = list->pred;
+      if (ismarked(load(pred->next)) || !below(pred, key, list))
+        pred = list->head;
+    }
+    curr = getpointer(load(pred->next));
+    list->trav++;
+    assert(below(pred, key, list));
+
+    do {
+      succ = load(curr->next);
+      while (ismarked(succ)) {
+        succ = getpointer(succ);
+        if (!cas(pred->next, curr, succ)) {
+          list->fail++;
+          if constexpr (Start::head) {
+            list->rtry++;
+            goto retry;
+          } else {
+            next = load(pred->next);
+            if (ismarked(next)) {
+              list->rtry++;
+              goto retry;
+            }
+            succ = next;
+          }
+        } else if constexpr (Links::doubly) {
+          store(succ->prev, pred);
+        }
+
+        curr = getpointer(succ);
+        succ = load(succ->next);
+        list->trav++;
+      }
+      if constexpr (Links::doubly) {
+        if (load(curr->prev) != pred)
+          store(curr->prev, pred);
+      }
+
+      if (!below(curr, key, list)) {
+        list->pred = pred;
+        list->curr = curr;
+        return;
+      }
+      pred = curr;
+      curr = getpointer(load(curr->next));
+      list->trav++;
+    } while (1);
+  }
+
+  static int add(KeyArg key, List *list)
+  {
+    Node *pred, *curr, *node;
+
+    node = nullptr; // allocated once the key is known to be absent
+
+    if constexpr (!Start::cursor)
+      list->pred = list->head;
+    do {
+      pos(key, list);
+      pred = list->pred;
+      curr = list->curr;
+      if (same(curr, key, list)) {
+        if (node != nullptr)
+          slabfree(node, &list->slab);
+        return 0; // already there
+      }
+
+      if (node == nullptr) {
+        node = new (slaballoc(&list->slab)) Node;
+        node->key = key;
+      }
+
+      node->next = curr;
+      if constexpr (Links::doubly)
+        node->prev = pred;
+
+      if (cas(pred->next, curr, node)) {
+        list->adds++;
+        if constexpr (Links::doubly)
+          store(curr->prev, node);
+        return 1;
+      }
+      list->fail++;
+    } while (1);
+  }
+
+  static int rem(KeyArg key, List *list)
+  {
+    Node *pred, *succ, *node;
+
+    do {
+      pos(key, list);
+      pred = list->pred;
+      node = list->curr;
+      if (!same(node, key, list))
+        return 0; // not there
+
+      if constexpr (Mark::textbook) {
+        succ = getpointer(load(node->next)); // unmarked
+        if (!cas(node->next, succ, setmark(succ))) {
+          list->fail++;
+          continue;
+        }
+      } else if constexpr (Mark::fetch) {
+        succ = reinterpret_cast<Node*>(reinterpret_cast<std::atomic<uintptr_t>&>(node->next).fetch_or(1, Order::rmw));
+        if (ismarked(succ))
+          return 0;
+      } else {
+        succ = load(node->next);
+        do {
+          if (ismarked(succ))
+            return 0;
+          if (cas(node->next, succ, setmark(succ)))
+            break;
+          list->fail++;
+        } while (1);
+      }
+
+      cas(pred->next, node, succ); // else unlinked by a later traversal
+      if constexpr (Links::doubly)
+        store(succ->prev, pred);
+
+      list->rems++;
+      return 1;
+    } while (1);
+  }
+
+  // where lookups start the read-only traversal for key
+  static Node *start(KeyArg key, List *list)
+  {
+    Node *curr;
+
+    if constexpr (Links::doubly) {
+      curr = Start::cursor ? list->pred : list->head;
+      list->cons++;
+      // as in pos, never from a removed node: it may not lead to the key
+      while (above(curr, key, list) || ismarked(load(curr->next))) {
+        curr = load(curr->prev);
+        list->cons++;
+      }
+    } else if constexpr (Start::cursor) {
+      curr = list->pred;
+      if (above(curr, key, list) || ismarked(load(curr->next)))
+        curr = list->head;
+    } else {
+      curr = list->head;
+    }
+    assert(!above(curr, key, list));
+
+    return curr;
+  }
+
+  static int con(KeyArg key, List *list)
+  {
+    Node *curr;
+
+    curr = start(key, list);
+    while (below(curr, key, list)) {
+      curr = getpointer(load(curr->next));
+      list->cons++;
+    }
+
+    if constexpr (Start::cursor)
+      list->pred = curr;
+
+    return (same(curr, key, list) && !ismarked(load(curr->next)));
+  }
+
+  // the key of node is below key, always for head and never for tail
+  static bool below(const Node *node, KeyArg key, const List *list)
+  {
+    if constexpr (KeyType::sentinels)
+      return KeyType::less(node->key, key);
+    else
+      return node == list->head || (node != list->tail && KeyType::less(node->key, key));
+  }
+
+  // the key of node is above key, always for tail and never for head
+  static bool above(const Node *node, KeyArg key, const List *list)
+  {
+    if constexpr (KeyType::sentinels)
+      return KeyType::less(key, node->key);
+    else
+      return node == list->tail || (node != list->head && KeyType::less(key, node->key));
+  }
+
+  // the key of node, not below key, is key
+  static bool same(const Node *node, KeyArg key, const List *list)
+  {
+    if constexpr (KeyType::sentinels)
+      return node->key == key;
+    else
+      return !above(node, key, list);
+  }
+
+  // Links the sorted, distinct keys into the empty list, at quiescence
+  static void load(const Key keys[], int n, List *list)
+  {
+    Node *pred, *node;
+    int i;
+
+    pred = list->head;
+    for (i = 0; i < n; i++) {
+      node = new (slaballoc(&list->slab)) Node;
+      node->key = keys[i];
+      if constexpr (Links::doubly)
+        node->prev.store(pred, std::memory_order_relaxed);
+      pred->next.store(node, std::memory_order_relaxed);
+      pred = node;
+    }
+    pred->next.store(list->tail, std::memory_order_relaxed);
+    if constexpr (Links::doubly)
+      list->tail->prev.store(pred, std::memory_order_relaxed);
+  }
+
+  static Node *getpointer(Node *p)
+  {
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1));
+  }
+
+  static bool ismarked(Node *p)
+  {
+    return (reinterpret_cast<uintptr_t>(p) & 1) != 0;
+  }
+
+  static Node *setmark(Node *p)
+  {
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) | 1);
+  }
+
+private:
+  template <class T>
+  static T load(const std::atomic<T> &a)
+  {
+    return a.load(Order::load);
+  }
+
+  template <class T>
+  static void store(std::atomic<T> &a, T v)
+  {
+    a.store(v, Order::store);
+  }
+
+  // the expected value is updated on failure, as by the C11 CAS
+  template <class T>
+  static bool cas(std::atomic<T> &a, T &expected, T desired)
+  {
+    return a.compare_exchange_weak(expected, desired, Order::rmw, Order::fail);
+  }
+};
+
+} // namespace lockfree
+
+#endif
@@ -0,0 +1,105 @@
+/* Per thread hardware performance counters (Linux perf_event_open) */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "perfcount.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static int perfevent(unsigned type, unsigned long long config)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr,0,sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1; // allowed with perf_event_paranoid<=2
+  attr.exclude_hv = 1;
+  // for scaling when there are more events than hardware counters
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  // calling thread, any cpu
+  return (int)syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+}
+
+void perfopen(perf_t *perf)
+{
+  int i;
+
+  perf->fd[PERF_L1MISS] =
+    perfevent(PERF_TYPE_HW_CACHE,
+	      PERF_COUNT_HW_CACHE_L1D|
+	      (PERF_COUNT_HW_CACHE_OP_READ<<8)|
+	      (PERF_COUNT_HW_CACHE_RESULT_MISS<<16));
+  perf->fd[PERF_LLCMISS] =
+    perfevent(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+  perf->fd[PERF_CYCLES] =
+    perfevent(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES);
+  perf->fd[PERF_INSTR] =
+    perfevent(PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS);
+  perf->fd[PERF_BRMISS] =
+    perfevent(PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES);
+
+  for (i=0; i<PERFEVENTS; i++) perf->count[i] = 0;
+}
+
+void perfstart(perf_t *perf)
+{
+  int i;
+
+  for (i=0; i<PERFEVENTS; i++) {
+    if (perf->fd[i]<0) continue;
+    ioctl(perf->fd[i],PERF_EVENT_IOC_RESET,0);
+    ioctl(perf->fd[i],PERF_EVENT_IOC_ENABLE,0);
+  }
+}
+
+void perfstop(perf_t *perf)
+{
+  unsigned long long value[3]; // count, time enabled, time running
+  int i;
+
+  for (i=0; i<PERFEVENTS; i++) {
+    if (perf->fd[i]<0) continue;
+    ioctl(perf->fd[i],PERF_EVENT_IOC_DISABLE,0);
+    if (read(perf->fd[i],value,sizeof(value))==sizeof(value) && value[2]>0) {
+      if (value[2]<value[1])
+        value[0] = (unsigned long long)((double)value[0]*value[1]/value[2]);
+      perf->count[i] += value[0];
+    } else {
+      close(perf->fd[i]);
+      perf->fd[i] = -1;
+    }
+  }
+}
+
+void perfclose(perf_t *perf)
+{
+  int i;
+
+  for (i=0; i<PERFEVENTS; i++)
+    if (perf->fd[i]>=0) close(perf->fd[i]);
+}
+#else
+// no counters on this platform
+void perfopen(perf_t *perf)
+{
+  int i;
+
+  for (i=0; i<PERFEVENTS; i++) {
+    perf->fd[i] = -1;
+    perf->count[i] = 0;
+  }
+}
+
+void perfstart(perf_t *perf) {}
+void perfstop(perf_t *perf) {}
+void perfclose(perf_t *perf) {}
+#endif
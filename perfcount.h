@@ -0,0 +1,18 @@
+/* Per thread hardware performance counters (Linux perf_event_open) */
+
+#define PERF_L1MISS  0 // L1 data cache read misses
+#define PERF_LLCMISS 1 // last level cache misses
+#define PERF_CYCLES  2 // CPU cycles
+#define PERF_INSTR   3 // retired instructions
+#define PERF_BRMISS  4 // mispredicted branches
+#define PERFEVENTS   5
+
+typedef struct _perf {
+  int fd[PERFEVENTS]; // -1 if the counter is not available
+  unsigned long long count[PERFEVENTS];
+} perf_t;
+
+void perfopen(perf_t *perf);  // counters of the calling thread, disabled
+void perfstart(perf_t *perf);
+void perfstop(perf_t *perf);  // accumulates into count, scaled if multiplexed
+void perfclose(perf_t *perf);
@@ -0,0 +1,301 @@
+/* Improved lock-free linked list implementations */
+/* The C interface of linkedlist.h for the variants of lockfreelist.hpp */
+
+#include <cstring>
+#include <cstddef>
+#include <climits>
+
+#include <stdatomic.h> // _Atomic of linkedlist.h (C++23)
+
+extern "C" {
+#include "linkedlist.h"
+}
+
+#include "lockfreelist.hpp"
+
+using namespace lockfree;
+
+namespace {
+
+typedef Types<node_t, list_t> C; // on the nodes and lists of linkedlist.h
+
+struct strvariant {
+  void (*init)(node_t*, node_t*, list_t*);
+  int (*add)(const char*, list_t*);
+  int (*rem)(const char*, list_t*);
+  int (*con)(const char*, list_t*);
+};
+
+struct variant {
+  void (*init)(node_t*, node_t*, list_t*);
+  void (*pos)(long, list_t*);
+  int (*add)(long, list_t*);
+  int (*rem)(long, list_t*);
+  int (*con)(long, list_t*);
+  void (*load)(const long[], int, list_t*);
+  bool cursor;
+  strvariant str[2]; // STR_PLAIN, STR_PREFIX
+};
+
+// The string lists on the storage of list_t and of the node_t sentinels;
+// their keys are not compared, and list_t starts as BasicList.
+template <class L>
+struct strings {
+  typedef typename L::Node N;
+  typedef typename L::List S;
+
+  static_assert(offsetof(N, next) == offsetof(node_t, next) && offsetof(N, prev) == offsetof(node_t, prev) &&
+                sizeof(N) <= sizeof(node_t), "string sentinels in node_t");
+  static_assert(offsetof(S, head) == offsetof(list_t, head) && offsetof(S, tail) == offsetof(list_t, tail) &&
+                offsetof(S, curr) == offsetof(list_t, curr) && offsetof(S, pred) == offsetof(list_t, pred) &&
+                offsetof(S, slab) == offsetof(list_t, slab) && offsetof(S, adds) == offsetof(list_t, adds) &&
+                offsetof(S, rtry) == offsetof(list_t, rtry), "string lists in list_t");
+
+  static void init(node_t *head, node_t *tail, list_t *list)
+  {
+    L::init(reinterpret_cast<N*>(head), reinterpret_cast<N*>(tail), reinterpret_cast<S*>(list));
+  }
+
+  static int add(const char *key, list_t *list)
+  {
+    return L::add(key, reinterpret_cast<S*>(list));
+  }
+
+  static int rem(const char *key, list_t *list)
+  {
+    return L::rem(key, reinterpret_cast<S*>(list));
+  }
+
+  static int con(const char *key, list_t *list)
+  {
+    return L::con(key, reinterpret_cast<S*>(list));
+  }
+
+  static constexpr strvariant ops()
+  {
+    return {init, add, rem, con};
+  }
+};
+
+template <class... Policies>
+constexpr variant make()
+{
+  typedef LockFreeList<Policies..., C> L;
+
+  return {L::init, L::pos, L::add, L::rem, L::con, L::load, L::Start::cursor,
+          {strings<LockFreeList<Policies..., StringKeys>>::ops(),
+           strings<LockFreeList<Policies..., PrefixKeys>>::ops()}};
+}
+
+// the executables of linkedlist.c, in the order of policies
+const variant variants[] = {
+  make<FromHead, CasMark>(),
+  make<FromPred>(),
+  make<FromPred, Doubly>(),
+  make<FromCursor, Doubly>(),
+  make<FromCursor>(),
+  make<FromCursor, FetchOrMark>(),
+};
+
+const variant *selected = &variants[0];
+int keys = STR_NONE;
+
+} // namespace
+
+extern "C" {
+
+const char *policies[] = {
+  "draconic",
+  "singly",
+  "doubly",
+  "doubly_cursor",
+  "singly_cursor",
+  "singly_cursor_fetch",
+  NULL
+};
+
+static_assert(sizeof(variants)/sizeof(variants[0]) == sizeof(policies)/sizeof(policies[0])-1,
+              "a name per variant");
+
+int policy(const char *name)
+{
+  int i;
+
+  for (i = 0; policies[i] != NULL; i++) {
+    if (strcmp(policies[i], name) == 0) {
+      selected = &variants[i];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+const char *policyname(void)
+{
+  return policies[selected-variants];
+}
+
+void create(node_t *head, node_t *tail)
+{
+  LockFreeList<C>::create(head, tail); // the same for all variants
+}
+
+void destroy(node_t *head, node_t *tail)
+{
+}
+
+void init(node_t *head, node_t *tail, list_t *list)
+{
+  if (keys == STR_NONE)
+    selected->init(head, tail, list);
+  else
+    selected->str[keys-1].init(head, tail, list);
+  list->upds = 0;
+  list->pubs = 0;
+  list->hits = 0;
+  list->elim = 0;
+  list->shard = &list->own;
+  list->own.adds = 0;
+  list->own.rems = 0;
+}
+
+void clean(list_t *list)
+{
+  LockFreeList<C>::clean(list);
+}
+
+int add(long key, list_t *list)
+{
+  int res;
+
+  res = selected->add(key, list);
+  ADDED(list, res);
+  return res;
+}
+
+int rem(long key, list_t *list)
+{
+  int res;
+
+  res = selected->rem(key, list);
+  REMOVED(list, res);
+  return res;
+}
+
+int con(long key, list_t *list)
+{
+  return selected->con(key, list);
+}
+
+void strkeys(int style)
+{
+  keys = style;
+}
+
+int addstr(const char *key, list_t *list)
+{
+  int res;
+
+  res = selected->str[keys-1].add(key, list);
+  ADDED(list, res);
+  return res;
+}
+
+int remstr(const char *key, list_t *list)
+{
+  int res;
+
+  res = selected->str[keys-1].rem(key, list);
+  REMOVED(list, res);
+  return res;
+}
+
+int constr(const char *key, list_t *list)
+{
+  return selected->str[keys-1].con(key, list);
+}
+
+// linked by one thread of the team
+void load(long keys[], int n, int team, list_t *list)
+{
+  if (team) {
+#pragma omp single
+    {
+      selected->load(keys, n, list);
+      ADDED(list, n);
+    }
+  } else {
+    selected->load(keys, n, list);
+    ADDED(list, n);
+  }
+}
+
+// one operation per key, from the pred of the previous key
+void add_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = add(keys[i], list);
+}
+
+void rem_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  if (!selected->cursor)
+    list->pred = list->head;
+  for (i = 0; i < n; i++)
+    res[i] = rem(keys[i], list);
+}
+
+void con_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = selected->con(keys[i], list);
+}
+
+void range(long lo, long hi, iter_t *iter, list_t *list)
+{
+  if (lo == LONG_MIN)
+    lo++; // the head
+
+  if (!selected->cursor)
+    list->pred = list->head;
+  selected->pos(lo, list);
+  iter->list = list;
+  iter->curr = list->curr;
+  iter->lo = lo;
+  iter->hi = hi;
+}
+
+int rangenext(iter_t *iter, long *key)
+{
+  typedef LockFreeList<C> L;
+  list_t *list;
+  node_t *curr, *succ;
+
+  list = iter->list;
+  curr = iter->curr;
+  while (curr != list->tail && curr->key <= iter->hi) {
+    succ = curr->next.load(std::memory_order_acquire);
+    list->trav++;
+    if (!L::ismarked(succ)) {
+      *key = curr->key;
+      iter->curr = succ;
+      return 1;
+    }
+    curr = L::getpointer(succ);
+  }
+  iter->curr = curr;
+
+  return 0;
+}
+
+void rangedone(iter_t *iter)
+{
+}
+
+} // extern "C"
@@ -1,9 +1,12 @@
-rm steady_results.csv
+THREADS="${THREADS:-1,2,4,6,8,12,16}"
+
+# one process per executable: every thread count 5 times, summarized
+rm -f steady_results.csv
 for d in "ldraconic" "lsingly" "ldoubly" "ldoubly_cursor" "lsingly_cursor" "lsingly_cursor_fetch" ; do
-  for thread in 1 2 4 6 8 12 16 ; do
-    for i in {1..5} ; do
-      echo "$d $thread threads; run $i"
-      ./build/$d -p $thread -B S -f 16384 -U 32768 -A 25 -R 25 -c 50000 -C >> steady_results.csv
-    done
-  done
+  echo "$d threads $THREADS"
+  if [ -s steady_results.csv ]; then
+    ./build/$d -B S -p $THREADS -N 5 -f 16384 -U 32768 -A 25 -R 25 -c 50000 | tail -n +2 >> steady_results.csv
+  else
+    ./build/$d -B S -p $THREADS -N 5 -f 16384 -U 32768 -A 25 -R 25 -c 50000 >> steady_results.csv
+  fi
 done
@@ -0,0 +1,104 @@
+/* Per thread slab allocation of list nodes */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <assert.h>
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#endif
+
+#include "slab.h"
+
+int slabpolicy = SLAB_DEFAULT;
+int slabnode = 0;
+const char *slabnames[] = {"default", "local", "interleave", "bind", NULL};
+
+typedef struct _chunk {
+  struct _chunk *next;
+  int policy; // how the chunk was allocated
+  char padding[CACHELINE-sizeof(struct _chunk*)-sizeof(int)];
+} chunk_t;
+
+void slabinit(slab_t *slab, size_t size)
+{
+  assert(size >= sizeof(void*));
+
+  slab->free = NULL;
+  slab->bump = NULL;
+  slab->end = NULL;
+  slab->chunks = NULL;
+  slab->size = size;
+}
+
+void *slabgrow(slab_t *slab)
+{
+  chunk_t *chunk;
+  int policy;
+  void *obj;
+
+  policy = slabpolicy;
+#ifdef HAVE_NUMA
+  if (policy == SLAB_LOCAL && numa_available() != -1)
+    chunk = (chunk_t*)numa_alloc_local(SLABCHUNK);
+  else if (policy == SLAB_INTERLEAVE && numa_available() != -1)
+    chunk = (chunk_t*)numa_alloc_interleaved(SLABCHUNK);
+  else if (policy == SLAB_BIND && numa_available() != -1)
+    chunk = (chunk_t*)numa_alloc_onnode(SLABCHUNK, slabnode);
+  else
+#endif
+  {
+    policy = SLAB_DEFAULT;
+    chunk = (chunk_t*)aligned_alloc(CACHELINE, SLABCHUNK);
+  }
+  assert(chunk != NULL);
+  chunk->next = (chunk_t*)slab->chunks;
+  chunk->policy = policy;
+  slab->chunks = chunk;
+
+  slab->bump = (char*)(chunk+1);
+  slab->end = (char*)chunk+SLABCHUNK;
+
+  obj = slab->bump;
+  slab->bump += slab->size;
+  return obj;
+}
+
+// all objects from this slab become invalid, wherever they are
+void slabrelease(slab_t *slab)
+{
+  chunk_t *next, *chunk;
+
+  next = (chunk_t*)slab->chunks;
+  while (next != NULL) {
+    chunk = next;
+    next = next->next;
+#ifdef HAVE_NUMA
+    if (chunk->policy != SLAB_DEFAULT) {
+      numa_free(chunk, SLABCHUNK);
+      continue;
+    }
+#endif
+    free(chunk);
+  }
+  slabinit(slab, slab->size);
+}
+
+int slabnuma(void)
+{
+#ifdef HAVE_NUMA
+  if (numa_available() != -1)
+    return slabpolicy != SLAB_BIND || (slabnode >= 0 && slabnode <= numa_max_node());
+#endif
+  return 0;
+}
+
+int slabnodes(void)
+{
+#ifdef HAVE_NUMA
+  if (numa_available() != -1)
+    return numa_max_node()+1;
+#endif
+  return 1;
+}
@@ -0,0 +1,67 @@
+/* Per thread slab allocation of list nodes */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SLABCHUNK (1<<20) // bytes per chunk
+#define CACHELINE 64
+
+// chunk placement
+#define SLAB_DEFAULT    0 // first touch by the allocating thread
+#define SLAB_LOCAL      1 // explicitly on the NUMA node of the allocating thread
+#define SLAB_INTERLEAVE 2 // pages round robin over all NUMA nodes
+#define SLAB_BIND       3 // on NUMA node slabnode
+
+extern int slabpolicy;
+extern int slabnode;
+extern const char *slabnames[];
+
+int slabnuma(void); // whether the chunks can be placed, otherwise SLAB_DEFAULT
+int slabnodes(void);
+
+typedef struct _slab {
+  void *free;       // free objects, linked through their first word
+  char *bump, *end; // unused part of the current chunk
+  void *chunks;     // all chunks of this slab, for bulk release
+  size_t size;      // object size
+} slab_t;
+
+void slabinit(slab_t *slab, size_t size);
+void *slabgrow(slab_t *slab);
+void slabrelease(slab_t *slab);
+
+// objects can be freed to any slab of the same object size
+static inline void *slaballoc(slab_t *slab)
+{
+  void *obj;
+
+  obj = slab->free;
+  if (obj != NULL) {
+    slab->free = *(void**)obj;
+    return obj;
+  }
+  if (slab->bump+slab->size <= slab->end) {
+    obj = slab->bump;
+    slab->bump += slab->size;
+    return obj;
+  }
+  return slabgrow(slab);
+}
+
+static inline void slabfree(void *obj, slab_t *slab)
+{
+  *(void**)obj = slab->free;
+  slab->free = obj;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
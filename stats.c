@@ -0,0 +1,81 @@
+/* Sharded per thread counters of a list, for size() and live statistics */
+
+#include <stdlib.h>
+
+#include <assert.h>
+
+#include "stats.h"
+
+stats_t *statscreate(void)
+{
+  stats_t *stats;
+  int i;
+
+  stats = (stats_t*)malloc(sizeof(stats_t));
+  assert(stats != NULL);
+  stats->shard = (shard_t*)aligned_alloc(CACHELINE, SHARDS*sizeof(shard_t));
+  assert(stats->shard != NULL);
+  for (i = 0; i < SHARDS; i++) {
+    atomic_init(&stats->shard[i].adds, 0);
+    atomic_init(&stats->shard[i].rems, 0);
+  }
+  atomic_init(&stats->shards, 0);
+
+  return stats;
+}
+
+void statsdestroy(stats_t *stats)
+{
+  free(stats->shard);
+  free(stats);
+}
+
+// shards are kept after their thread is gone, so that the counts stay
+shard_t *statsattach(stats_t *stats)
+{
+  int i;
+
+  i = atomic_fetch_add(&stats->shards, 1);
+  assert(i < SHARDS);
+
+  return &stats->shard[i];
+}
+
+void statsread(stats_t *stats, opstats_t *ops)
+{
+  int i, n;
+
+  ops->adds = 0;
+  ops->rems = 0;
+  n = atomic_load_explicit(&stats->shards, memory_order_acquire);
+  for (i = 0; i < n; i++) {
+    ops->adds += atomic_load_explicit(&stats->shard[i].adds, memory_order_relaxed);
+    ops->rems += atomic_load_explicit(&stats->shard[i].rems, memory_order_relaxed);
+  }
+  ops->size = (long)(ops->adds-ops->rems);
+  ops->threads = n;
+}
+
+long size(stats_t *stats)
+{
+  opstats_t ops;
+
+  statsread(stats, &ops);
+  return ops.size;
+}
+
+// the same counts in two passes
+long sizeexact(stats_t *stats)
+{
+  opstats_t ops, again;
+
+  atomic_thread_fence(memory_order_acquire);
+  statsread(stats, &ops);
+  do {
+    again = ops;
+    atomic_thread_fence(memory_order_acquire);
+    statsread(stats, &ops);
+  } while (ops.adds != again.adds || ops.rems != again.rems || ops.threads != again.threads);
+
+  return ops.size;
+}
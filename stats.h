@@ -0,0 +1,52 @@
+/* Sharded per thread counters of a list, for size() and live statistics */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdatomic.h>
+
+#include "slab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHARDS 1024 // threads per list
+
+// a cache line, written by its thread only
+typedef struct _shard {
+  _Atomic(unsigned long long) adds, rems; // successful
+  char padding[CACHELINE-2*sizeof(unsigned long long)];
+} shard_t;
+
+typedef struct _stats {
+  shard_t *shard;        // SHARDS, cache line aligned
+  _Atomic(int) shards;   // attached threads
+} stats_t;
+
+typedef struct _opstats {
+  unsigned long long adds, rems;
+  long size;
+  int threads;
+} opstats_t;
+
+stats_t *statscreate(void);
+void statsdestroy(stats_t *stats);
+shard_t *statsattach(stats_t *stats); // the shard of the calling thread
+
+long size(stats_t *stats);      // approximate while threads add and rem
+long sizeexact(stats_t *stats); // exact at quiescence, waits for a stable count otherwise
+void statsread(stats_t *stats, opstats_t *ops); // by any thread, at any time
+
+// by the thread of the shard: a load and a store, no read-modify-write
+static inline void shardadd(_Atomic(unsigned long long) *counter, unsigned long long n)
+{
+  atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed)+n,
+                        memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,643 @@
+/* Lock-free unrolled list: sorted blocks of keys per node */
+
+// Each node holds up to BLOCK sorted keys, and is never modified once it
+// is linked, except for its next pointer. The key of a node is its largest
+// key, so pos() finds the node that could hold a key exactly as the
+// singly linked list does. Updates replace the node: the next pointer of
+// the old node is marked and points to the replacement (one node, two
+// after a split, or the old successor if the node became empty), which in
+// turn ends with the old successor. The marked node is then unlinked as in
+// linkedlist.c. Before a node is merged into its predecessor, its next
+// pointer is frozen, and whoever finds a frozen node completes the merge.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include <stdatomic.h> // gcc -latomic
+
+#include <assert.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "linkedlist.h"
+
+//#define DOUBLY
+//#define CURSOR
+
+#ifdef MAP
+#error "the unrolled list has no values"
+#endif
+#if defined(EPOCH) || defined(HAZARD)
+#error "replaced nodes of the unrolled list are only released by clean()"
+#endif
+#ifdef FINGERS
+#error "the unrolled list has one cursor"
+#endif
+#ifdef COMBINE
+#error "the unrolled list has no combiner"
+#endif
+
+#define UNMARK_MASK ~3
+#define MARK_BIT   0x0000000000001 // replaced, points to the replacement
+#define FREEZE_BIT 0x0000000000002 // to be merged into the predecessor
+
+#define getpointer(_markedpointer)  ((node_t*)(((long)_markedpointer) & UNMARK_MASK))
+#define ismarked(_markedpointer)    ((((long)_markedpointer) & MARK_BIT) != 0x0)
+#define isfrozen(_markedpointer)    ((((long)_markedpointer) & FREEZE_BIT) != 0x0)
+#define isinvalid(_markedpointer)   ((((long)_markedpointer) & ~UNMARK_MASK) != 0x0)
+#define setmark(_markedpointer)     ((node_t*)(((long)_markedpointer) | MARK_BIT))
+#define setfreeze(_markedpointer)   ((node_t*)(((long)_markedpointer) | FREEZE_BIT))
+
+#define MERGE (BLOCK/4) // nodes with fewer keys are merged with their successor
+
+#ifdef SC
+#define CAS(_a,_e,_d) atomic_compare_exchange_weak(_a,_e,_d)
+#define LOAD(_a)      atomic_load(_a)
+#define STORE(_a,_e)  atomic_store(_a,_e)
+#else
+#define CAS(_a,_e,_d) atomic_compare_exchange_weak_explicit(_a,_e,_d,memory_order_acq_rel,memory_order_acquire)
+#define LOAD(_a)      atomic_load_explicit(_a,memory_order_acquire)
+#define STORE(_a,_e)  atomic_store_explicit(_a,_e,memory_order_release)
+#endif
+
+// contention management, as in linkedlist.c
+#define BACKOFFCAS(_l)   backoff(&(_l)->backoff)
+#define BACKOFFSTART(_l) backoffstart(&(_l)->backoff,(_l)->fail+(_l)->rtry)
+
+// number of keys in node smaller than key
+static inline int rank(long key, node_t *node)
+{
+  int r;
+
+#if defined(__AVX512F__) && BLOCK%8 == 0
+  __m512i k = _mm512_set1_epi64(key);
+  int i;
+
+  r = 0;
+  for (i = 0; i < BLOCK; i += 8)
+    r += __builtin_popcount(_mm512_cmplt_epi64_mask(_mm512_loadu_si512(&node->keys[i]), k));
+#elif defined(__AVX2__) && BLOCK%4 == 0
+  __m256i k = _mm256_set1_epi64x(key);
+  int i;
+
+  r = 0;
+  for (i = 0; i < BLOCK; i += 4) {
+    __m256i less = _mm256_cmpgt_epi64(k, _mm256_loadu_si256((__m256i*)&node->keys[i]));
+    r += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+  }
+#else
+  for (r = 0; r < node->count && node->keys[r] < key; r++);
+#endif
+
+  return r;
+}
+
+static node_t *fill(long keys[], int n, node_t *next, node_t *prev, list_t *list)
+{
+  node_t *node;
+  int i;
+
+  assert(0 < n && n <= BLOCK);
+
+  node = (node_t*)slaballoc(&list->slab);
+  for (i = 0; i < n; i++)
+    node->keys[i] = keys[i];
+  for (; i < BLOCK; i++)
+    node->keys[i] = LONG_MAX;
+  node->count = n;
+  node->key = keys[n-1];
+  node->next = next;
+  node->prev = prev;
+
+  return node;
+}
+
+// new nodes for the sorted keys, split in two if there are more than BLOCK
+static node_t *make(long keys[], int n, node_t *next, node_t *prev,
+                    node_t **last, list_t *list)
+{
+  node_t *first, *second;
+  int h;
+
+  assert(n <= 2*BLOCK);
+
+  if (n <= BLOCK) {
+    first = fill(keys, n, next, prev, list);
+    *last = first;
+  } else {
+    h = n/2;
+    second = fill(keys+h, n-h, next, NULL, list);
+    first = fill(keys, h, second, prev, list);
+    second->prev = first;
+    *last = second;
+  }
+
+  return first;
+}
+
+static void discard(node_t *first, node_t *last, list_t *list)
+{
+  if (last != first)
+    slabfree(last, &list->slab);
+  slabfree(first, &list->slab);
+}
+
+// Replace curr, whose next pointer is succ, by nodes holding keys[0..n-1]
+// followed by after (succ, or the successor of succ when merging). The
+// update takes effect with the marking of curr; unlinking it from pred
+// (if known) is left to pos() if it fails.
+static int replace(node_t *pred, node_t *curr, node_t *succ, node_t *after,
+                   long keys[], int n, list_t *list)
+{
+  node_t *first, *last;
+
+  if (n > 0)
+    first = make(keys, n, after, pred, &last, list);
+  else
+    first = last = after;
+
+  if (!CAS(&curr->next, &succ, setmark(first))) {
+    INC(list->fail);
+    BACKOFFCAS(list);
+    if (n > 0)
+      discard(first, last, list);
+    return 0;
+  }
+
+  if (pred != NULL && CAS(&pred->next, &curr, first)) {
+#ifdef DOUBLY
+    STORE(&after->prev, n > 0 ? last : pred);
+#endif
+  }
+
+  return 1;
+}
+
+// complete the merge of the frozen curr with its predecessor pred
+static void help(node_t *ppred, node_t *pred, node_t *curr, node_t *succ,
+                 list_t *list)
+{
+  long keys[2*BLOCK];
+  node_t *node;
+  int n;
+
+  if (pred == list->head) {
+    // nothing to merge with, replace by an unfrozen copy
+    node = fill(curr->keys, curr->count, getpointer(succ), pred, list);
+    if (!CAS(&pred->next, &curr, node))
+      slabfree(node, &list->slab);
+    return;
+  }
+
+  n = pred->count;
+  memcpy(keys, pred->keys, n*sizeof(long));
+  memcpy(keys+n, curr->keys, curr->count*sizeof(long));
+  n += curr->count;
+  replace(ppred, pred, curr, getpointer(succ), keys, n, list);
+}
+
+// pred is the last node with a key smaller than key, curr the node that
+// holds key if it is present; ppred is the predecessor of pred, or NULL
+static void pos(long key, node_t **ppred, list_t *list)
+{
+  node_t *pp, *pred, *succ, *curr, *next;
+
+  pred = list->pred;
+#ifdef DOUBLY
+#ifndef CURSOR
+  if (key <= KEY(pred))
+    pred = list->head;
+#endif
+
+retry:
+  while (isinvalid(LOAD(&pred->next)) || key <= KEY(pred)) {
+    INC(list->trav);
+    pred = LOAD(&pred->prev);
+  }
+#else // DOUBLY
+retry:
+  pred = list->pred;
+  if (isinvalid(LOAD(&pred->next)) || key <= KEY(pred))
+    pred = list->head;
+#endif // DOUBLY
+  pp = NULL;
+  curr = getpointer(LOAD(&pred->next));
+  INC(list->trav);
+  assert(KEY(pred) < key);
+
+  do {
+    succ = LOAD(&curr->next);
+    if (ismarked(succ)) {
+      next = getpointer(succ);
+      if (CAS(&pred->next, &curr, next)) {
+#ifdef DOUBLY
+        if (LOAD(&next->prev) == curr)
+          STORE(&next->prev, pred);
+#endif
+        curr = next;
+      } else {
+        INC(list->fail);
+        BACKOFFCAS(list);
+        if (isinvalid(curr)) {
+          INC(list->rtry);
+          goto retry;
+        }
+      }
+      INC(list->trav);
+      continue;
+    }
+    if (isfrozen(succ)) {
+      help(pp, pred, curr, succ, list);
+      INC(list->rtry);
+      goto retry;
+    }
+#ifdef DOUBLY
+    if (LOAD(&curr->prev) != pred)
+      STORE(&curr->prev, pred);
+#endif
+
+    if (key <= KEY(curr)) {
+      list->pred = pred;
+      list->curr = curr;
+      *ppred = pp;
+      return;
+    }
+    pp = pred;
+    pred = curr;
+    curr = succ;
+    INC(list->trav);
+  } while (1);
+}
+
+void create(node_t *head, node_t *tail)
+{
+  int i;
+
+  // the sentinels hold no keys
+  head->key = LONG_MIN;
+  head->count = 0;
+  head->next = tail;
+  head->prev = NULL;
+
+  tail->key = LONG_MAX;
+  tail->count = 0;
+  tail->next = NULL;
+  tail->prev = head;
+
+  for (i = 0; i < BLOCK; i++) {
+    head->keys[i] = LONG_MAX;
+    tail->keys[i] = LONG_MAX;
+  }
+}
+
+void destroy(node_t *head, node_t *tail)
+{
+}
+
+void init(node_t *head, node_t *tail, list_t *list)
+{
+  list->head = head;
+  list->tail = tail;
+
+  list->pred = head;
+  list->curr = NULL;
+
+  slabinit(&list->slab, sizeof(node_t));
+  backoffinit(&list->backoff);
+  list->shard = &list->own;
+  list->own.adds = 0;
+  list->own.rems = 0;
+
+#ifdef COUNTERS
+  list->adds = 0;
+  list->rems = 0;
+  list->cons = 0;
+  list->trav = 0;
+  list->fail = 0;
+  list->rtry = 0;
+  list->upds = 0;
+  list->pubs = 0;
+  list->hits = 0;
+  list->elim = 0;
+#endif
+}
+
+void clean(list_t *list)
+{
+  // at quiescence: linked and replaced nodes alike
+  slabrelease(&list->slab);
+}
+
+int add(long key, list_t *list)
+{
+  node_t *pp, *pred, *curr, *succ, *node;
+  long keys[BLOCK+1];
+  int n, r;
+
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  BACKOFFSTART(list);
+  do {
+    pos(key, &pp, list);
+    pred = list->pred;
+    curr = list->curr;
+
+    if (curr != list->tail) {
+      r = rank(key, curr);
+      if (r < curr->count && curr->keys[r] == key)
+        return 0; // already there
+
+      succ = LOAD(&curr->next);
+      if (isinvalid(succ))
+        continue;
+      n = curr->count;
+      memcpy(keys, curr->keys, r*sizeof(long));
+      keys[r] = key;
+      memcpy(keys+r+1, curr->keys+r, (n-r)*sizeof(long));
+      if (replace(pred, curr, succ, succ, keys, n+1, list)) {
+        INC(list->adds);
+        ADDED(list, 1);
+        return 1;
+      }
+    } else if (pp != NULL && pred->count < BLOCK) {
+      // extend the last node, which is replaced in its predecessor
+      n = pred->count;
+      memcpy(keys, pred->keys, n*sizeof(long));
+      keys[n] = key;
+      if (replace(pp, pred, curr, curr, keys, n+1, list)) {
+        list->pred = pp;
+        INC(list->adds);
+        ADDED(list, 1);
+        return 1;
+      }
+    } else {
+      node = fill(&key, 1, curr, pred, list);
+      if (CAS(&pred->next, &curr, node)) {
+        INC(list->adds);
+        ADDED(list, 1);
+#ifdef DOUBLY
+        STORE(&list->tail->prev, node);
+#endif
+        return 1;
+      }
+      slabfree(node, &list->slab);
+      INC(list->fail);
+      BACKOFFCAS(list);
+    }
+  } while (1);
+}
+
+int rem(long key, list_t *list)
+{
+  node_t *pp, *pred, *curr, *succ, *next;
+  long keys[2*BLOCK];
+  int n, r;
+
+  BACKOFFSTART(list);
+  do {
+    pos(key, &pp, list);
+    pred = list->pred;
+    curr = list->curr;
+    if (curr == list->tail)
+      return 0; // not there
+
+    r = rank(key, curr);
+    if (r >= curr->count || curr->keys[r] != key)
+      return 0; // not there
+
+    succ = LOAD(&curr->next);
+    if (isinvalid(succ))
+      continue;
+    n = curr->count;
+    memcpy(keys, curr->keys, r*sizeof(long));
+    memcpy(keys+r, curr->keys+r+1, (n-r-1)*sizeof(long));
+    n--;
+
+    if (n < MERGE && succ != list->tail) {
+      // freeze the successor and merge it into the replacement
+      next = LOAD(&succ->next);
+      if (!isinvalid(next) && CAS(&succ->next, &next, setfreeze(next)))
+        next = setfreeze(next);
+      if (isfrozen(next) && !ismarked(next)) {
+        memcpy(keys+n, succ->keys, succ->count*sizeof(long));
+        if (replace(pred, curr, succ, getpointer(next), keys, n+succ->count, list)) {
+          INC(list->rems);
+          REMOVED(list, 1);
+          return 1;
+        }
+        continue;
+      }
+    }
+
+    if (replace(pred, curr, succ, succ, keys, n, list)) {
+      INC(list->rems);
+      REMOVED(list, 1);
+      return 1;
+    }
+  } while (1);
+}
+
+int con(long key, list_t *list)
+{
+  node_t *pp, *pred, *curr, *succ;
+  int r;
+
+#ifdef DOUBLY
+#ifdef CURSOR
+  pred = list->pred;
+#else
+  pred = list->head;
+#endif
+  INC(list->cons);
+  while (key <= KEY(pred)) {
+    pred = LOAD(&pred->prev);
+    INC(list->cons);
+  }
+#else // DOUBLY
+#ifdef CURSOR
+  pred = list->pred;
+  if (key <= KEY(pred))
+    pred = list->head;
+#else
+  pred = list->head;
+#endif
+#endif // DOUBLY
+  assert(KEY(pred) < key);
+
+  // replaced nodes are passed through their replacement
+  curr = getpointer(LOAD(&pred->next));
+  INC(list->cons);
+  do {
+    succ = LOAD(&curr->next);
+    if (ismarked(succ)) {
+      curr = getpointer(succ);
+      INC(list->cons);
+      continue;
+    }
+    if (isfrozen(succ)) {
+      // a frozen node may already have been merged, find the live one
+      pos(key, &pp, list);
+      pred = list->pred;
+      curr = list->curr;
+      break;
+    }
+    if (key <= KEY(curr))
+      break;
+    pred = curr;
+    curr = succ;
+    INC(list->cons);
+  } while (1);
+
+#ifdef CURSOR
+  list->pred = pred;
+#endif
+
+  r = rank(key, curr);
+  return (r < curr->count && curr->keys[r] == key);
+}
+
+static void chain(node_t **nodes, int i, int m, list_t *list)
+{
+  nodes[i]->next = (i+1 < m) ? nodes[i+1] : list->tail;
+  nodes[i]->prev = (i > 0) ? nodes[i-1] : list->head;
+}
+
+static void finish(node_t **nodes, int m, list_t *list)
+{
+  list->head->next = (m > 0) ? nodes[0] : list->tail;
+  list->tail->prev = (m > 0) ? nodes[m-1] : list->head;
+}
+
+// full nodes of BLOCK keys, see linkedlist.c
+void load(long keys[], int n, int team, list_t *list)
+{
+  node_t **nodes;
+  int i, m;
+
+  m = (n+BLOCK-1)/BLOCK;
+  if (!team) {
+    nodes = (node_t**)malloc(m*sizeof(node_t*));
+    assert(m == 0 || nodes != NULL);
+    for (i = 0; i < m; i++)
+      nodes[i] = fill(keys+i*BLOCK, (i < m-1) ? BLOCK : n-i*BLOCK, NULL, NULL, list);
+    for (i = 0; i < m; i++)
+      chain(nodes, i, m, list);
+    finish(nodes, m, list);
+    ADDED(list, n);
+    free(nodes);
+    return;
+  }
+
+#pragma omp single copyprivate(nodes)
+  {
+    nodes = (node_t**)malloc(m*sizeof(node_t*));
+    assert(m == 0 || nodes != NULL);
+  }
+#pragma omp for schedule(static)
+  for (i = 0; i < m; i++)
+    nodes[i] = fill(keys+i*BLOCK, (i < m-1) ? BLOCK : n-i*BLOCK, NULL, NULL, list);
+#pragma omp for schedule(static)
+  for (i = 0; i < m; i++)
+    chain(nodes, i, m, list);
+#pragma omp single
+  {
+    finish(nodes, m, list);
+    ADDED(list, n);
+    free(nodes);
+  }
+}
+
+// one operation per key, starting from the cursor (CURSOR)
+void add_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = add(keys[i], list);
+}
+
+void rem_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = rem(keys[i], list);
+}
+
+void con_batch(long keys[], int n, int res[], list_t *list)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    res[i] = con(keys[i], list);
+}
+
+void range(long lo, long hi, iter_t *iter, list_t *list)
+{
+  node_t *pp;
+
+  if (lo == LONG_MIN)
+    lo++; // the head
+
+#ifndef CURSOR
+  list->pred = list->head;
+#endif
+  pos(lo, &pp, list);
+  iter->list = list;
+  iter->curr = list->curr;
+  iter->i = rank(lo, iter->curr);
+  iter->lo = lo;
+  iter->hi = hi;
+}
+
+int rangenext(iter_t *iter, long *key)
+{
+  list_t *list;
+  node_t *pp, *curr, *succ;
+
+  list = iter->list;
+  curr = iter->curr;
+  while (iter->lo <= iter->hi) {
+    succ = LOAD(&curr->next);
+    if (ismarked(succ)) {
+      // replaced, continue in the replacement
+      curr = getpointer(succ);
+      iter->i = rank(iter->lo, curr);
+      INC(list->trav);
+      continue;
+    }
+    if (isfrozen(succ)) {
+      // the keys may already have been merged into the predecessor
+      pos(iter->lo, &pp, list);
+      curr = list->curr;
+      iter->i = rank(iter->lo, curr);
+      continue;
+    }
+    if (curr == list->tail)
+      break;
+    if (iter->i < curr->count) {
+      if (curr->keys[iter->i] > iter->hi)
+        break;
+      *key = curr->keys[iter->i++];
+      iter->lo = *key+1;
+      iter->curr = curr;
+      return 1;
+    }
+    curr = succ;
+    iter->i = 0;
+    INC(list->trav);
+  }
+  iter->curr = curr;
+
+  return 0;
+}
+
+void rangedone(iter_t *iter)
+{
+}
@@ -0,0 +1,182 @@
+/* Key distributions and operation mixes of the steady benchmark */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "workload.h"
+
+const char *distnames[] = {"uniform", "regions", "zipf", "hotspot", "shift", "asc", "desc", NULL};
+
+int workloadparse(workload_t *wl, const char *spec)
+{
+  size_t len;
+  int d;
+
+  for (d = 0; distnames[d] != NULL; d++) {
+    len = strlen(distnames[d]);
+    if (strncmp(spec, distnames[d], len) == 0 && (spec[len] == '\0' || spec[len] == ':'))
+      break;
+  }
+  if (distnames[d] == NULL || d == DIST_REGIONS)
+    return 0;
+  wl->dist = d;
+  spec += strlen(distnames[d]);
+  if (*spec == ':')
+    spec++;
+  else
+    return 1; // the defaults
+
+  switch (d) {
+  case DIST_ZIPF:
+    return sscanf(spec, "%lf", &wl->theta) == 1 && wl->theta > 0.0 && wl->theta < 1.0;
+  case DIST_HOTSPOT:
+    return sscanf(spec, "%d,%d", &wl->hotops, &wl->hotkeys) == 2 &&
+           wl->hotops >= 0 && wl->hotops <= 100 && wl->hotkeys > 0 && wl->hotkeys <= 100;
+  case DIST_SHIFT:
+    return sscanf(spec, "%ld,%ld", &wl->window, &wl->period) >= 1 && wl->window > 0 && wl->period > 0;
+  default:
+    return 0;
+  }
+}
+
+void workloadinit(workload_t *wl, long U)
+{
+  double zeta2;
+  long i;
+
+  wl->U = U;
+  if (wl->hot > 0 && wl->width > U/wl->hot) wl->width = U/wl->hot;
+  if (wl->width < 1) wl->width = 1;
+  if (wl->window > U) wl->window = U;
+  if (wl->dist == DIST_ZIPF) {
+    // Gray et al., Quickly generating billion-record synthetic databases
+    wl->zetan = 0.0;
+    for (i = 1; i <= U; i++)
+      wl->zetan += 1.0/pow((double)i, wl->theta);
+    zeta2 = 1.0+1.0/pow(2.0, wl->theta);
+    wl->eta = (1.0-pow(2.0/U, 1.0-wl->theta))/(1.0-zeta2/wl->zetan);
+  }
+}
+
+char *workloadname(const workload_t *wl, char *buf, size_t size)
+{
+  switch (wl->dist) {
+  case DIST_REGIONS: snprintf(buf, size, "regions:%ld,%ld", wl->hot, wl->width); break;
+  case DIST_ZIPF:    snprintf(buf, size, "zipf:%g", wl->theta); break;
+  case DIST_HOTSPOT: snprintf(buf, size, "hotspot:%d,%d", wl->hotops, wl->hotkeys); break;
+  case DIST_SHIFT:   snprintf(buf, size, "shift:%ld,%ld", wl->window, wl->period); break;
+  default:           snprintf(buf, size, "%s", distnames[wl->dist]);
+  }
+  return buf;
+}
+
+static const struct {
+  const char *name;
+  int ins, upd, scan; // percent, the rest are lookups
+  int dist;
+} mixes[] = {
+  {"a", 0, 50, 0, DIST_ZIPF},  // update heavy
+  {"b", 0, 5, 0, DIST_ZIPF},   // read mostly
+  {"c", 0, 0, 0, DIST_ZIPF},   // read only
+  {"d", 5, 0, 0, DIST_SHIFT},  // read latest: the window follows the inserts
+  {"e", 5, 0, 95, DIST_ZIPF},  // short ranges
+  {"f", 0, 50, 0, DIST_ZIPF},  // read-modify-write
+  {NULL, 0, 0, 0, 0}
+};
+
+int workloadmix(const char *name, int map, int *pa, int *pr, int *pu, int *ps)
+{
+  int m;
+
+  for (m = 0; mixes[m].name != NULL && strcmp(mixes[m].name, name) != 0; m++);
+  if (mixes[m].name == NULL)
+    return -1;
+  *pa = mixes[m].ins;
+  *pr = 0;
+  *pu = 0;
+  *ps = mixes[m].scan;
+  if (map)
+    *pu = mixes[m].upd;
+  else {
+    *pa += mixes[m].upd/2;
+    *pr += mixes[m].upd-mixes[m].upd/2;
+  }
+  return mixes[m].dist;
+}
+
+static uint64_t splitmix(uint64_t *x)
+{
+  uint64_t z;
+
+  z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+  z = (z^(z>>27))*0x94D049BB133111EBULL;
+  return z^(z>>31);
+}
+
+void genseed(gen_t *gen, const workload_t *wl, unsigned seed, int t, int p)
+{
+  uint64_t x;
+  int i;
+
+  x = (uint64_t)seed<<32 | (unsigned)t;
+  for (i = 0; i < 4; i++)
+    gen->s[i] = splitmix(&x);
+  gen->wl = wl;
+  gen->next = (wl->U/p)*t;
+  gen->draws = 0;
+}
+
+static inline double genunit(gen_t *gen)
+{
+  return (genrand(gen)>>11)*0x1.0p-53;
+}
+
+static inline long genbelow(gen_t *gen, long n)
+{
+  return (long)(genrand(gen)%(uint64_t)n);
+}
+
+long genkey(gen_t *gen)
+{
+  const workload_t *wl = gen->wl;
+  long U = wl->U, k, hotn;
+  double u, uz;
+
+  switch (wl->dist) {
+  case DIST_REGIONS:
+    k = genbelow(gen, wl->hot*wl->width);
+    return (k/wl->width)*(U/wl->hot)+k%wl->width;
+  case DIST_ZIPF:
+    u = genunit(gen);
+    uz = u*wl->zetan;
+    if (uz < 1.0)
+      return 0;
+    if (uz < 1.0+pow(0.5, wl->theta))
+      return 1;
+    k = (long)(U*pow(wl->eta*u-wl->eta+1.0, 1.0/(1.0-wl->theta)));
+    return (k < U) ? k : U-1;
+  case DIST_HOTSPOT:
+    hotn = U*wl->hotkeys/100;
+    if (hotn < 1)
+      hotn = 1;
+    if (genint(gen, 100) < wl->hotops || hotn == U)
+      return genbelow(gen, hotn);
+    return hotn+genbelow(gen, U-hotn);
+  case DIST_SHIFT:
+    k = (long)(gen->draws++/wl->period);
+    return (k+genbelow(gen, wl->window))%U;
+  case DIST_ASC:
+    k = gen->next;
+    gen->next = (k+1 < U) ? k+1 : 0;
+    return k;
+  case DIST_DESC:
+    k = gen->next;
+    gen->next = (k > 0) ? k-1 : U-1;
+    return k;
+  default:
+    return genbelow(gen, U);
+  }
+}
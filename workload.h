@@ -0,0 +1,80 @@
+/* Key distributions and operation mixes of the steady benchmark */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// key distributions over [0,U)
+#define DIST_UNIFORM 0
+#define DIST_REGIONS 1 // hot regions of width keys, spread evenly (-H)
+#define DIST_ZIPF    2 // key k with probability ~ 1/(k+1)^theta, 0 the hottest
+#define DIST_HOTSPOT 3 // hotops percent of the keys in the first hotkeys percent
+#define DIST_SHIFT   4 // uniform in a window moving up by one key every period keys
+#define DIST_ASC     5 // per thread ascending from its share of [0,U), wrapping around
+#define DIST_DESC    6 // per thread descending
+
+extern const char *distnames[];
+
+typedef struct _workload {
+  int dist;
+  long U;
+  long hot, width;       // DIST_REGIONS
+  double theta;          // DIST_ZIPF, in (0,1)
+  double zetan, eta;     // zeta(U,theta), for the inverse
+  int hotops, hotkeys;   // DIST_HOTSPOT
+  long window, period;   // DIST_SHIFT
+} workload_t;
+
+typedef struct _gen {
+  uint64_t s[4];         // xoshiro256**
+  const workload_t *wl;
+  long next;             // DIST_ASC and DIST_DESC
+  unsigned long draws;   // DIST_SHIFT
+} gen_t;
+
+int workloadparse(workload_t *wl, const char *spec); // like zipf:0.99, 0 if malformed
+void workloadinit(workload_t *wl, long U);           // after parsing, zeta for DIST_ZIPF
+char *workloadname(const workload_t *wl, char *buf, size_t size);
+
+// YCSB-like mixes a to f: percentages of adds, removes, updates and
+// scans (the rest are lookups) and the key distribution; updates are
+// replace for MAP, otherwise a remove or an add each
+int workloadmix(const char *name, int map, int *pa, int *pr, int *pu, int *ps);
+
+void genseed(gen_t *gen, const workload_t *wl, unsigned seed, int t, int p);
+long genkey(gen_t *gen);
+
+static inline uint64_t genrand(gen_t *gen)
+{
+  uint64_t *s = gen->s;
+  uint64_t r, t;
+
+  r = s[1]*5;
+  r = (r<<7 | r>>57)*9;
+  t = s[1]<<17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = s[3]<<45 | s[3]>>19;
+  return r;
+}
+
+// in [0,n), n small
+static inline int genint(gen_t *gen, int n)
+{
+  return (int)((genrand(gen)>>32)*n>>32);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif